@@ -0,0 +1,122 @@
+#ifndef PLANO_ASYNC_EVALUATION_H
+#define PLANO_ASYNC_EVALUATION_H
+
+/* Async_evaluation.h
+ * Running the graph off the UI thread (api::EvaluateAsync).
+ *
+ * A request does the first half of an evaluation (evaluation.h) on the calling thread: it finds the dirty steps and
+ * copies what they need into a snapshot.  Each one keeps its Evaluate callback, its properties (the defaults it
+ * shares, or a copy) and its input and output offsets, and the snapshot holds its own copy of every slot those steps
+ * read or write, renumbered.  Nothing in it points back into the nodes, so they can be edited, added and deleted
+ * while it runs.  The worker has no current context, since the UI thread keeps using it: only the context's blob
+ * store is current there, for callbacks that make blobs.  The steps are then marked run, as if they had been:
+ * edits made from now on dirty them again for the next request, like after an Evaluate.
+ *
+ * The snapshot goes to an AsyncEvaluator: one background thread, which runs the steps in order, or on a WorkPool
+ * of its own with more than one evaluation thread.  A newer request cancels the snapshot in flight (it stops at
+ * the next step and is dropped) and claims its steps again, by node id, so nothing it would have computed is lost.
+ * So does an Evaluate, which then runs them itself.
+ *
+ * A finished snapshot is published on the UI thread (by Frame, or api::PollEvaluation): its output values are
+ * copied into the slots of the same pins, all at once.  Until then readers see the previous values.
+ */
+
+#include <plano_types.h>
+#include <internal/property_blob.h>
+#include <internal/work_pool.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+class MemoCache;
+
+// One step of a snapshot.
+struct AsyncStep {
+    void (*Evaluate)(const ::Properties&, const types::Value* const*, types::Value*);
+    std::shared_ptr<const ::Properties> Properties;
+    uintptr_t Node;            // Id of the node.
+    uint32_t  Inputs;          // First of its entries in EvaluationSnapshot::Sources.
+    uint32_t  InputCount;
+    uint32_t  Outputs;         // First of its slots.  Consecutive, like in EvaluationState.
+    uint32_t  OutputCount;
+    uint32_t  Dependents;      // First of its entries in EvaluationSnapshot::Dependents.
+    uint32_t  DependentCount;
+    uint32_t  Upstream = 0;    // Steps of the snapshot it waits for.
+    std::string MemoKey;       // Pure steps: MemoKeyPrefix.  Empty if the step doesn't use the cache.
+};
+
+struct EvaluationSnapshot {
+    std::vector<AsyncStep>         Steps;        // Upstream first.
+    std::vector<uint32_t>          Dependents;
+    std::vector<uint32_t>          Sources;      // Slot each input reads, for every step's inputs.
+    std::vector<types::Value>      Values;       // The slots the steps read or write.
+    std::vector<uintptr_t>         SlotPins;     // Slot -> the pin id that owns it in the graph.
+    prop_blob_store*               Blobs = nullptr; // The context's.  Current while the steps run, for callbacks that make blobs.
+    unsigned                       Threads = 1;
+    MemoCache*                     Memo = nullptr;
+    std::atomic<bool>              Cancelled { false };
+    std::vector<double>            Timings;      // Per step, while profiling: seconds its call took.  Empty otherwise.
+
+    // The worker's own, while it runs.
+    std::vector<const types::Value*>         Arguments;
+    WorkPool*                                Pool = nullptr;
+    std::unique_ptr<std::atomic<uint32_t>[]> Remaining;
+    std::vector<std::string>                 Keys;
+};
+
+// The background thread snapshots run on, started with the first one.
+class AsyncEvaluator {
+public:
+    AsyncEvaluator() = default;
+    ~AsyncEvaluator();   // Stops the thread, once the snapshot it runs, if any, returns.
+    AsyncEvaluator(const AsyncEvaluator&) = delete;
+    AsyncEvaluator& operator=(const AsyncEvaluator&) = delete;
+
+    void Submit(std::shared_ptr<EvaluationSnapshot> snapshot);   // Replaces one still waiting to run.
+    std::shared_ptr<EvaluationSnapshot> TakeFinished();          // The last snapshot run to the end, nullptr if none since.
+    void Wait(const EvaluationSnapshot* snapshot);               // Returns once it finished.  It must not be cancelled.
+
+private:
+    void Loop();
+
+    std::mutex                          Lock;
+    std::condition_variable             Wake;      // Something to run, or Quit.
+    std::condition_variable             Done;      // Finished changed.
+    std::shared_ptr<EvaluationSnapshot> Next;
+    std::shared_ptr<EvaluationSnapshot> Finished;
+    std::unique_ptr<WorkPool>           Pool;      // Only touched by the thread.
+    std::thread                         Thread;
+    bool                                Quit = false;
+};
+
+struct AsyncEvaluationState {
+    std::shared_ptr<EvaluationSnapshot> Current;   // Requested and not published yet.
+    AsyncEvaluator                      Worker;
+
+    ~AsyncEvaluationState() { if (Current) Current->Cancelled = true; }   // So Worker's thread stops soon.
+};
+
+// Snapshots the dirty steps and starts running them (see api::EvaluateAsync).  False if the graph has a cycle.
+bool StartAsyncEvaluation();
+
+// Copies the outputs of a finished snapshot into the graph.  True if there was one.
+bool PublishAsyncEvaluation();
+
+// Waits for the snapshot in flight, if any, and publishes it.
+void FinishAsyncEvaluation();
+
+// Cancels the snapshot in flight, if any, and dirties its steps again.
+void AbandonAsyncEvaluation();
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_ASYNC_EVALUATION_H
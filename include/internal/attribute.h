@@ -10,6 +10,70 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <memory>
+#include <vector>
+#include <internal/property_key.h>
+#include <internal/property_schema.h>
+#include <internal/property_codec.h>
+#include <internal/property_blob.h>
+#include <internal/property_writes.h>
+
+/* Type: attr_map
+ * A std::map that can also be indexed with an interned key (no temporary std::string is built).
+ * While its table is tracked, operator[], erase and clear note what they touch in the write log (property_writes.h).
+ * The log belongs to the table the map is in, so copying or moving a map never takes it along.
+*/
+template <typename T>
+class attr_map : public std::map<std::string, T> {
+public:
+    using std::map<std::string, T>::erase;
+
+    attr_map() = default;
+    attr_map(const attr_map& other): std::map<std::string, T>(other) {}
+    attr_map(attr_map&& other) noexcept: std::map<std::string, T>(std::move(other)) {}
+    attr_map& operator=(const attr_map& other) { std::map<std::string, T>::operator=(other); return *this; }
+    attr_map& operator=(attr_map&& other) noexcept { std::map<std::string, T>::operator=(std::move(other)); return *this; }
+
+    T& operator[](const std::string& name) {
+        auto found = this->lower_bound(name);
+        bool existed = found != this->end() && !this->key_comp()(name, found->first);
+        if (log)
+            note(name, existed ? &found->second : nullptr);
+        if (!existed)
+            found = this->emplace_hint(found, name, T());
+        return found->second;
+    }
+    T& operator[](const prop_key& key) { return (*this)[*key.name]; }
+
+    size_t erase(const std::string& name) {
+        if (log) {
+            auto found = this->find(name);
+            note(name, found == this->end() ? nullptr : &found->second);
+        }
+        return std::map<std::string, T>::erase(name);
+    }
+    void clear(void) {
+        if (log)
+            log->everything = true;
+        std::map<std::string, T>::clear();
+    }
+
+private:
+    friend class attr_table;
+
+    void note(const std::string& name, const T* current) {
+        if (log->everything || log->find(type, name))
+            return;
+        log->writes.emplace_back();
+        prop_write& w = log->writes.back();
+        w.type = type;
+        w.name = name;
+        w.save(current);
+    }
+
+    prop_write_log* log = nullptr;
+    prop_type       type = prop_type::empty;
+};
 
 /* Type: attr_table
  *
@@ -17,26 +81,79 @@
 
 class attr_table {
 public:
-    std::map <std::string, std::string> pstring;
-    std::map <std::string, int>         pint;
-    std::map <std::string, float>       pfloat;
-    std::map <std::string, bool>        pbool;
+    attr_map <std::string> pstring;
+    attr_map <int>         pint;
+    attr_map <float>       pfloat;
+    attr_map <bool>        pbool;
+    attr_map <prop_blob>   pints;      // Arrays and blobs, see property_blob.h.  Read with p.pfloats["curve"].as<float>(),
+    attr_map <prop_blob>   pfloats;    // write with p.pfloats["curve"] = prop_blob::from_array(values).
+    attr_map <prop_blob>   pblob;
     
     // serializer.
     // returns the serialized text.
     // returns by reference "entries" which specifies the number of prperties in this table. (intent: when writing to a file for long term storage, the parser
     // that reads it can know in advance where in the file to stop parsing for properties.)
-    std::string serialize(unsigned long& entries) const;
+    // With "defaults", properties that equal theirs are left out (a delta).
+    std::string serialize(unsigned long& entries, const attr_table* defaults = nullptr) const;
 
-    // deseralizer
-    void deseralize(const std::string& serialized_table);
+    // deseralizer.  With "merge", the record is applied over the current contents (eg. a delta over a copy of the defaults).
+    void deseralize(const std::string& serialized_table, bool merge = false);
+
+    // Binary encoding (see property_codec.h).  decode returns false if the record is malformed.  Same options as above.
+    void encode(std::string& out, prop_dictionary& dict, const attr_table* defaults = nullptr) const;
+    bool decode(const char* data, size_t size, const prop_dictionary& dict, bool merge = false);
     
+    // Empties the table.  With a schema, its fields come back at their defaults.
     void clear(void);
+
+    // Appends the key of every property that differs from "before" (changed, added or removed).
+    void diff(const attr_table& before, std::vector<prop_key>& changed) const;
+
+    // Copy-on-write support (see api::NodeDescription).  covers is true if every key of "defaults" is here too,
+    // which a delta (below) needs, since it can't express a missing default.
+    bool equals(const attr_table& other) const;
+    bool covers(const attr_table& defaults) const;
+
+    // attr_table has no block layout: a schema only supplies the defaults (and prop_field handles look up the maps).
+    void set_schema(std::shared_ptr<const prop_schema> layout);
+    const prop_schema* get_schema(void) const { return schema.get(); }
+
+    // Write tracking (property_writes.h).  track(nullptr) detaches the log; the log is never copied with the table.
+    // logged_changes appends the key of every logged property whose value differs now.
+    void track(prop_write_log* log);
+    void logged_changes(const prop_write_log& log, std::vector<prop_key>& changed) const;
+
+    int&         operator[](const prop_field<int>& field)         { return pint[field.key]; }
+    float&       operator[](const prop_field<float>& field)       { return pfloat[field.key]; }
+    bool&        operator[](const prop_field<bool>& field)        { return pbool[field.key]; }
+    std::string& operator[](const prop_field<std::string>& field) { return pstring[field.key]; }
+
+    // Read-only, and nullptr instead of creating a missing property.
+    const int*         find(const prop_field<int>& field) const         { return find(pint, field.key); }
+    const float*       find(const prop_field<float>& field) const       { return find(pfloat, field.key); }
+    const bool*        find(const prop_field<bool>& field) const        { return find(pbool, field.key); }
+    const std::string* find(const prop_field<std::string>& field) const { return find(pstring, field.key); }
+
+private:
+    template <typename T>
+    static const T* find(const attr_map<T>& map, const prop_key& key) {
+        auto found = map.find(*key.name);
+        return found == map.end() ? nullptr : &found->second;
+    }
+
+    std::shared_ptr<const prop_schema> schema;
 };
 
 // C to Instance adaptor to comply with API needs.
-std::string Prop_Serialize(const attr_table& Prop_In, unsigned long& entries);
-void Prop_Deserialize(attr_table& Prop_In, const std::string& serialized_table);
+std::string Prop_Serialize(const attr_table& Prop_In, unsigned long& entries, const attr_table* Defaults = nullptr);
+void Prop_Deserialize(attr_table& Prop_In, const std::string& serialized_table, bool Merge = false);
+void Prop_SerializeBinary(const attr_table& Prop_In, prop_dictionary& dict, std::string& out, const attr_table* Defaults = nullptr);
+bool Prop_DeserializeBinary(attr_table& Prop_In, const prop_dictionary& dict, const char* data, size_t size, bool Merge = false);
+void Prop_Diff(const attr_table& Before, const attr_table& After, std::vector<prop_key>& changed);
+bool Prop_Equal(const attr_table& A, const attr_table& B);
+bool Prop_Covers(const attr_table& Prop_In, const attr_table& Defaults);
+void Prop_Track(attr_table& Prop_In, prop_write_log* Log);
+void Prop_LoggedChanges(const attr_table& Prop_In, const prop_write_log& Log, std::vector<prop_key>& changed);
 
 
 #endif // ATTRIBUTE_H
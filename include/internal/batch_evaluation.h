@@ -0,0 +1,59 @@
+#ifndef PLANO_BATCH_EVALUATION_H
+#define PLANO_BATCH_EVALUATION_H
+
+/* Batch_evaluation.h
+ * Running the graph over many records at once (api::EvaluateBatch).
+ *
+ * A batch reuses the schedule of evaluation.h, slot for slot, but a Bool, Int or Float slot holds a column of
+ * Count values instead of one.  All columns live in one arena, 32 byte aligned so kernels (batch_kernels.h) can use
+ * full vectors.  String and Object slots stay single values, shared by every record: those are the values of the
+ * last api::Evaluate, since batches don't compute them.
+ *
+ * Before the steps run, every column a step doesn't write is filled: an unlinked input from its SetPinBatch values
+ * if it has some, otherwise (and for outputs of nodes without an Evaluate) with its slot's single value, repeated.
+ * Steps then run in schedule order, all of them (a batch has no dirty tracking), through EvaluateBatch if the node
+ * type has one and through Evaluate once per record otherwise.
+ */
+
+#include <plano_types.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+// Values given to an unlinked input with SetPinBatch.
+struct BatchInput {
+    types::PinType       Type;
+    size_t               Count;
+    std::vector<uint8_t> Bytes;
+};
+
+struct BatchState {
+    size_t Count = 0;                                  // Records of the last batch.
+    unsigned long long Built = ~0ull;                  // The schedule (EvaluationState::Built) the columns are laid out for.
+    std::vector<uint8_t>   Arena;                      // Every column.
+    std::vector<size_t>    Columns;                    // Slot -> its column's offset from the arena's first aligned byte, SIZE_MAX if it has none.
+    std::vector<types::PinType> Types;                 // Slot -> its pin's type.
+    std::vector<uint8_t>   Written;                    // Slot -> a step writes it.
+    std::unordered_map<uintptr_t, BatchInput> Inputs;  // SetPinBatch, by pin id.  Kept across rebuilds.
+
+    std::vector<types::ValueSpan> Spans;               // Scratch: one call's inputs, then outputs.
+    std::vector<types::Value>     Scalars;             // Scratch: one record's inputs, then outputs, for Evaluate.
+    std::vector<const types::Value*> Pointers;         // Scratch: Evaluate's input pointers.
+};
+
+// Runs every step over "count" records.  False if links form a cycle or an input's SetPinBatch has fewer values.
+bool EvaluateGraphBatch(size_t count);
+
+// Stores "count" values of the pin's type for an unlinked input.  False if the pin isn't an input of that type.
+bool SetBatchInput(ax::NodeEditor::PinId id, types::PinType type, const void* values, size_t count);
+
+// The column of a pin from the last batch, nullptr if it has none of that type (or the graph changed since).
+const void* BatchColumn(ax::NodeEditor::PinId id, types::PinType type);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_BATCH_EVALUATION_H
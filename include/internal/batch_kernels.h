@@ -0,0 +1,44 @@
+#ifndef PLANO_BATCH_KERNELS_H
+#define PLANO_BATCH_KERNELS_H
+
+/* Batch_kernels.h
+ * Span kernels for batch evaluation (see batch_evaluation.h) and the built-in nodes that use them.
+ *
+ * Every kernel reads n values from each input array and writes n to its output.  Outputs may alias inputs.  There
+ * are three sets: plain C++, SSE2 and AVX2, picked on first use by what the CPU (and OS) supports.  The SIMD sets
+ * fall back to the plain loop for their tails and for the operations their instruction set lacks (eg. 32 bit
+ * integer multiply in SSE2), and every set gives bit identical results: integer math wraps, integer division by
+ * zero gives 0, and Min/Max follow the SSE rule (a < b ? a : b) when a NaN is involved.  Bools are bytes, 0 or 1.
+ */
+
+#include <cstddef>
+
+namespace plano {
+namespace internal {
+
+enum BatchMath    { BatchAdd, BatchSubtract, BatchMultiply, BatchDivide, BatchMin, BatchMax, BatchMathCount };
+enum BatchCompare { BatchLess, BatchGreater, BatchEqual, BatchCompareCount };
+
+enum class BatchLevel { Scalar, SSE2, AVX2 };
+
+struct BatchKernels {
+    const char* Name;   // "scalar", "sse2" or "avx2".
+    void (*FloatMath[BatchMathCount])(const float* a, const float* b, float* out, size_t n);
+    void (*IntMath[BatchMathCount])(const int* a, const int* b, int* out, size_t n);
+    void (*FloatCompare[BatchCompareCount])(const float* a, const float* b, bool* out, size_t n);
+    void (*IntCompare[BatchCompareCount])(const int* a, const int* b, bool* out, size_t n);
+    void (*FloatSelect)(const bool* c, const float* a, const float* b, float* out, size_t n);   // c ? a : b
+    void (*IntSelect)(const bool* c, const int* a, const int* b, int* out, size_t n);
+    void (*And)(const bool* a, const bool* b, bool* out, size_t n);
+    void (*Or)(const bool* a, const bool* b, bool* out, size_t n);
+    void (*Not)(const bool* a, bool* out, size_t n);
+};
+
+BatchLevel          DetectBatchLevel();                 // The best level this CPU runs.
+const BatchKernels& GetBatchKernels(BatchLevel level);  // Levels above DetectBatchLevel() give the best there is.
+const BatchKernels& GetBatchKernels();                  // The best level, detected once.
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_BATCH_KERNELS_H
@@ -0,0 +1,44 @@
+#ifndef PLANO_COMPRESSION_H
+#define PLANO_COMPRESSION_H
+
+/* Compression.h
+ * Block compression for saved projects.
+ *
+ * Buffers are cut into fixed-size chunks and every chunk is compressed on its own with a small LZ77 codec
+ * (LZ4 block format: token, literals, 16 bit offset, match length).  Chunks never refer to each other, so they
+ * can be decompressed in parallel, or one at a time for random access.
+ *
+ * Frame layout (all integers little endian):
+ *   "PLZ1"                 magic
+ *   u32 chunk count
+ *   chunk count times:     u32 raw size, u32 stored size (high bit set: chunk is stored uncompressed)
+ *   chunk payloads, back to back
+ *
+ * Frames can be concatenated (eg. a compressed snapshot followed by compressed journal appends).
+ */
+
+#include <cstddef>
+#include <string>
+
+namespace plano {
+namespace internal {
+
+const size_t CompressionChunkSize = 64 * 1024; // Also keeps every match offset within 16 bits.
+
+// True if the buffer starts with a compressed frame.
+bool   IsCompressedFrame(const char* data, size_t size);
+
+// Compresses a whole buffer into a single frame.
+std::string CompressFrame(const char* data, size_t size);
+
+// Decompresses every frame in the buffer back to back.  Returns false if the data is corrupt.
+bool   DecompressFrames(const char* data, size_t size, std::string& out);
+
+// Random access to one frame.  ChunkCount returns 0 if the frame is corrupt.
+size_t ChunkCount(const char* frame, size_t size);
+bool   DecompressChunk(const char* frame, size_t size, size_t index, std::string& out);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_COMPRESSION_H
@@ -0,0 +1,155 @@
+#ifndef PLANO_EVALUATION_H
+#define PLANO_EVALUATION_H
+
+/* Evaluation.h
+ * Running the graph (api::Evaluate).
+ *
+ * The links are only read when the graph's structure changes: BuildSchedule then orders the nodes that have an
+ * Evaluate callback so every node comes after the nodes feeding it, gives every output pin a slot in one array of
+ * values, and resolves each input pin to the slot it reads (its link's output pin, or a slot of its own when it is
+ * unlinked).
+ *
+ * The schedule is then compiled into Tape: one instruction per step, holding the Evaluate callback, a pointer to
+ * the node's properties and the offsets of its input pointers (Arguments, resolved once to the slots they read)
+ * and output slots.  An evaluation is a loop over that tape, with no id, link or registry lookups and no touching
+ * of the nodes.  The properties pointer can move when a node stops sharing its defaults, which only happens on a
+ * write, so it is resolved again whenever the node's PropertyGeneration moves.
+ *
+ * With more than one thread (api::SetEvaluationThreads), the schedule runs on a WorkPool instead: every step gets
+ * an atomic count of the steps it waits for, the steps waiting for nothing are queued, and finishing a step counts
+ * its dependents down and queues those that reach zero.  A step only writes its own output slots and only reads
+ * slots of steps that finished before it was queued, so the values come out the same as a serial run.
+ *
+ * Anything that adds or removes nodes or links calls StructureChanged, which is what makes the schedule stale.
+ *
+ * Evaluation is incremental: a step only runs if it is dirty, and a dirty step dirties every step it feeds.  Steps
+ * in schedule order make that one forward pass.  A step is dirty when its node's PropertyGeneration (tracking.h)
+ * moved since it last ran, when SetPinValue changed one of its unlinked inputs, when MarkNodeDirty says so, or
+ * after a rebuild, when one of its inputs reads another pin than before (a link was added or removed, or the node
+ * feeding it was deleted).  Rebuilds carry every output value over by pin id, so clean steps keep them.
+ *
+ * A sliced evaluation (EvaluateGraphSlice) keeps no state of its own between calls: dirt is the state.  Each call
+ * redoes the dirty pass, runs dirty steps whose dirty inputs are all done until its time is up, and marks each one
+ * run as it finishes, so edits made between calls simply dirty more steps for the next one.
+ *
+ * A dirty step of a Pure node looks in Memo before it calls Evaluate: the key is the node's type, its serialized
+ * properties (kept per step until its PropertyGeneration moves) and its input values.  Object inputs count by
+ * pointer, so a pure node must not read an object that changes behind the same pointer.  The cache keeps the
+ * objects its keys name alive, so a pointer is never reused for a different object while a key names it.
+ */
+
+#include <plano_types.h>
+#include <internal/memo_cache.h>
+#include <internal/work_pool.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+// One node of the schedule.
+struct EvaluationStep {
+    size_t   Node;         // Position in s_Nodes.
+    uintptr_t Id;          // The node's id, to recognize it after a rebuild.
+    uint32_t Inputs;       // First of the node's entries in EvaluationState::Sources.
+    uint32_t Outputs;      // First of the node's slots.  A node's output slots are consecutive.
+    uint32_t Dependents;   // First of the step's entries in EvaluationState::Dependents.
+    uint32_t DependentCount;
+    uint32_t Upstream;     // Steps this one waits for (counted once per link).
+    bool     MainThreadOnly;
+    bool     Pure;
+    void   (*EvaluateBatch)(const ::Properties&, const types::ValueSpan*, const types::ValueSpan*); // See batch_evaluation.h.
+};
+
+// A step, compiled: all a call needs.
+struct EvaluationInstruction {
+    void (*Evaluate)(const ::Properties&, const types::Value* const*, types::Value*);
+    const ::Properties* Properties;   // nullptr until the step first runs after a rebuild or a property change.
+    uint32_t Arguments;    // First of the call's entries in EvaluationState::Arguments.
+    uint32_t Outputs;      // First of its slots in EvaluationState::Values.
+};
+
+struct EvaluationState {
+    unsigned long long Structure = 0;                  // Generation of the graph's structure, see StructureChanged.
+    unsigned long long Built = ~0ull;                  // Structure the schedule below was built for.
+    std::vector<EvaluationStep> Steps;                 // Upstream nodes first.
+    std::vector<uint32_t>       Sources;               // Slot each input pin reads, for every step's inputs.
+    std::vector<types::Value>   Values;                // Slots: every output pin, then every unlinked input pin.
+    uint32_t FirstInputSlot = 0;                       // Where the unlinked input pins' slots start.
+    std::vector<uintptr_t>      SlotPins;              // Slot -> the pin id that owns it.
+    std::unordered_map<uintptr_t, uint32_t> PinSlots;  // Pin id -> the slot it writes or reads.
+    std::vector<uint32_t>       StepOf;                // s_Nodes position -> its step, UINT32_MAX if it has none.
+    std::vector<uint32_t>       FirstInputs;           // s_Nodes position -> its first entry in Sources (and Arguments).
+    std::vector<uint32_t>       FirstOutputs;          // s_Nodes position -> its first output slot.
+    std::vector<uint32_t>       Readers;               // Steps reading each node's outputs, node after node.
+    std::vector<uint32_t>       FirstReaders;          // s_Nodes position -> its first entry in Readers, plus the end.
+    std::unordered_map<uintptr_t, types::Value> InputValues; // SetPinValue, by pin id.  Kept across rebuilds.
+    std::vector<uint32_t>       Dependents;            // Steps fed by each step, for every step.
+    std::vector<EvaluationInstruction> Tape;           // Per step, the schedule compiled.
+    std::vector<const types::Value*>   Arguments;      // Sources, as pointers into Values.
+    bool Cyclic = false;                               // Some nodes were left out of Steps, because links form a cycle.
+
+    std::vector<unsigned long long> Evaluated;         // Per step: the node's PropertyGeneration when it last ran.
+    std::vector<uint8_t>            Dirty;             // Per step: runs on the next evaluation.
+    size_t                          LastRun = 0;       // Steps the last evaluation ran.
+    std::vector<uintptr_t>          Visible;           // Ids of the nodes on screen at the last Frame, for EvaluateGraphSlice.
+    std::vector<uint8_t>            Wanted;            // Scratch, per step: a slice runs it first.
+    std::vector<uint32_t>           Waits;             // Scratch, per step: dirty steps feeding it that a slice hasn't run.
+    std::vector<double>             Timings;           // Per step, while profiling: seconds its last call took, < 0 if it didn't run.  See profiler.h.
+
+    unsigned                                  Threads = 1;  // See api::SetEvaluationThreads.
+    std::unique_ptr<WorkPool>                 Pool;         // Made on the first parallel run.
+    std::unique_ptr<std::atomic<uint32_t>[]>  Remaining;    // Per step: upstream steps still running.
+    std::vector<uint32_t>                     Ready;        // Scratch: the steps a parallel run starts with.
+
+    MemoCache                       Memo;              // Outputs of Pure steps, see api::SetMemoCapacity.
+    std::vector<std::string>        MemoKeys;          // Per Pure step: type and serialized properties, the key's start.
+    std::vector<unsigned long long> MemoKeyGenerations; // Per step: the PropertyGeneration MemoKeys was made at.
+    std::vector<std::string>        Keys;              // Per thread, scratch for one call's key.
+};
+
+// Call after adding or removing nodes or links (InvalidateIdIndex does, for nodes).
+void StructureChanged();
+
+// Rebuilds the schedule if the structure changed since it was built.
+void BuildSchedule();
+
+// Runs the schedule.  False if the graph has a cycle (the rest of it still runs).
+bool EvaluateGraph();
+
+// Runs dirty steps until "seconds" have passed, at least one, then returns; the next call picks up where it stopped
+// (see api::EvaluateSlice).  Steps of the nodes in Visible, and those feeding them, go first.  True once no step is
+// left dirty, unless the graph has a cycle.
+bool EvaluateGraphSlice(double seconds);
+
+// The two ends of a run, for anything that runs the steps itself (see async_evaluation.h): carries dirt down the
+// schedule and resolves the properties of the steps that will run, returning how many; then marks every step run.
+size_t CollectDirtySteps();
+void   MarkStepsEvaluated();
+
+// A Pure step's memo key is MemoKeyPrefix (its type and properties, cached until they change), then every input
+// value appended with AppendMemoValue.  The step's properties must be resolved.
+const std::string& MemoKeyPrefix(uint32_t step);
+void AppendMemoValue(std::string& key, const types::Value& value);
+
+// The slot of a pin that carries a value, nullptr otherwise.
+types::Value* PinValue(ax::NodeEditor::PinId id);
+
+// Gives an unlinked input pin its value (see api::SetPinValue) and dirties its node.
+void SetInputValue(ax::NodeEditor::PinId id, const types::Value& value);
+
+// Makes the node run on the next evaluation, with everything it feeds.
+void MarkNodeDirty(ax::NodeEditor::NodeId id);
+
+// Makes the steps reading the outputs of the node at s_Nodes position "node" run on the next evaluation, eg. after
+// something other than a step wrote them.  The schedule must be built.
+void MarkReadersDirty(size_t node);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_EVALUATION_H
@@ -6,6 +6,6 @@
 #include <internal/imgui_stdlib.h>
 
 
-void im_draw_basic_widgets (attr_table& Properties);
+void im_draw_basic_widgets (Properties& Properties);
 
 #endif // EXAMPLE_PROPERTY_IM_DRAW_H
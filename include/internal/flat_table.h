@@ -0,0 +1,214 @@
+#ifndef FLAT_TABLE_H
+#define FLAT_TABLE_H
+
+/* Flat_table.h
+ * Drop-in replacement for attr_table (see plano_properties.h, PLANO_FLAT_PROPERTIES).
+ * All four property types share one open-addressing table: one allocation per table instead of one per
+ * property, and a lookup is a short linear probe over prehashed slots instead of a tree walk.
+ * Keys are interned (property_key.h): a slot holds the key's handle, so looking up with a prop_key is an integer
+ * compare.  Int, float and bool values live inside the slot; string values use std::string's small buffer.
+ * With a schema (property_schema.h), the schema's int, float and bool fields live in one block instead of slots.
+ *
+ * Same surface as attr_table for widget code: p.pint["key"], p.pfloat["key"], ... and the same
+ * serialize/deseralize text, so save files are interchangeable between the two.
+ *
+ * Unlike std::map, adding a key can move the other values.  Don't hold a reference to one value
+ * across the creation of another (using &p.pint["x"] as a widget argument is fine).  Schema fields never move.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <internal/property_key.h>
+#include <internal/property_schema.h>
+#include <internal/property_codec.h>
+#include <internal/property_blob.h>
+#include <internal/property_writes.h>
+
+typedef prop_type flat_type;
+
+struct flat_slot {
+    uint32_t    hash = 0;        // slot hash of key and type, kept so probing and growing never rehash.
+    flat_type   type = flat_type::empty;
+    union {
+        int     i;
+        float   f;
+        bool    b;
+    } value = { 0 };
+    prop_key    key;
+    std::string str;             // value of pstring slots.
+    prop_blob   blob;            // value of pints, pfloats and pblob slots.
+};
+
+class flat_table;
+
+// One per property type.  Behaves like the std::map members of attr_table for the calls widgets make.
+// Arrays and blobs are all prop_blob values, told apart by Type.
+template <typename T, prop_type Type = prop_traits<T>::type>
+class flat_view {
+public:
+    T&     operator[](const std::string& key);
+    T&     operator[](const char* key);
+    T&     operator[](const prop_key& key);
+    size_t count(const std::string& key) const;
+    size_t erase(const std::string& key);     // Schema fields can't be erased, and report 0.
+
+    flat_view(const flat_view&) = delete;
+    flat_view& operator=(const flat_view&) = delete;
+
+private:
+    friend class flat_table;
+    explicit flat_view(flat_table* table): table(table) {}
+    flat_table* table;
+};
+
+class flat_table {
+public:
+    flat_view<std::string> pstring { this };
+    flat_view<int>         pint    { this };
+    flat_view<float>       pfloat  { this };
+    flat_view<bool>        pbool   { this };
+    flat_view<prop_blob, prop_type::pints>   pints   { this };   // See property_blob.h.
+    flat_view<prop_blob, prop_type::pfloats> pfloats { this };
+    flat_view<prop_blob, prop_type::pblob>   pblob   { this };
+
+    flat_table() = default;
+    flat_table(const flat_table& other): slots(other.slots), used(other.used), schema(other.schema), block(other.block) {}
+    flat_table(flat_table&& other) noexcept: slots(std::move(other.slots)), used(other.used), schema(std::move(other.schema)), block(std::move(other.block)) { other.used = 0; }
+    flat_table& operator=(const flat_table& other) { slots = other.slots; used = other.used; schema = other.schema; block = other.block; return *this; }
+    flat_table& operator=(flat_table&& other) noexcept { slots = std::move(other.slots); used = other.used; schema = std::move(other.schema); block = std::move(other.block); other.used = 0; return *this; }
+
+    // Same contract as attr_table::serialize / deseralize, "defaults" and "merge" included.
+    std::string serialize(unsigned long& entries, const flat_table* defaults = nullptr) const;
+    void deseralize(const std::string& serialized_table, bool merge = false);
+
+    // Binary encoding (see property_codec.h).  decode returns false if the record is malformed.
+    void encode(std::string& out, prop_dictionary& dict, const flat_table* defaults = nullptr) const;
+    bool decode(const char* data, size_t size, const prop_dictionary& dict, bool merge = false);
+
+    // Empties the table.  Schema fields stay, back at their defaults.
+    void clear(void);
+
+    // Appends the key of every property that differs from "before" (changed, added or removed).
+    void diff(const flat_table& before, std::vector<prop_key>& changed) const;
+
+    // Copy-on-write support (see api::NodeDescription).  equals compares values, not layout.  covers is true if
+    // every key of "defaults" is here too, which a delta needs, since it can't express a missing default.
+    bool equals(const flat_table& other) const;
+    bool covers(const flat_table& defaults) const;
+
+    size_t size(void) const { return used + (schema ? schema->fields.size() - schema->strings.size() : 0); }
+
+    // Lays the table out for a node type and resets it to the type's defaults (a copy of the prototype block).
+    void set_schema(std::shared_ptr<const prop_schema> layout);
+    const prop_schema* get_schema(void) const { return schema.get(); }
+
+    // Write tracking (property_writes.h).  While a log is attached, the mutable value(), operator[] and erase note
+    // the keys they hand out.  track(nullptr) detaches it; the copy and move constructors never take it along.
+    // logged_changes appends the key of every logged property whose value differs now.
+    void track(prop_write_log* write_log) { log = write_log; }
+    void logged_changes(const prop_write_log& write_log, std::vector<prop_key>& changed) const;
+
+    // Typed access.  A field of this table's schema is a fixed offset; anything else is a key lookup.
+    template <typename T>
+    T& operator[](const prop_field<T>& field) {
+        if (field.schema && field.schema == schema.get() && prop_traits<T>::type != prop_type::pstring) {
+            T* field_value = (T*)(block.data() + field.offset);
+            if (log)
+                note(field.key, prop_traits<T>::type, field_value);
+            return *field_value;
+        }
+        return *(T*)value(field.key, prop_traits<T>::type, true);
+    }
+    // Read-only, and nullptr instead of creating a missing property.
+    template <typename T>
+    const T* find(const prop_field<T>& field) const {
+        if (field.schema && field.schema == schema.get() && prop_traits<T>::type != prop_type::pstring)
+            return (const T*)(block.data() + field.offset);
+        return (const T*)value(field.key, prop_traits<T>::type);
+    }
+
+    // Pointer to the int, float, bool or std::string stored for key/type.  Creates it (zeroed) if "create" is set,
+    // otherwise returns nullptr when missing.
+    void* value(const char* key, size_t length, flat_type type, bool create);
+    void* value(const prop_key& key, flat_type type, bool create);
+    const void* value(const char* key, size_t length, flat_type type) const;
+    const void* value(const prop_key& key, flat_type type) const;
+    bool erase(const char* key, size_t length, flat_type type);
+
+    // Slot hash from prop_hash of the key, so "x" as an int and "x" as a float are different slots (like attr_table's maps).
+    static uint32_t hash(uint32_t key_hash, flat_type type);
+
+    // One property, as sorted_entries lists them.
+    struct entry {
+        flat_type       type;
+        const prop_key* key;
+        const void*     value;
+    };
+
+private:
+    size_t probe(const char* key, size_t length, flat_type type, uint32_t h) const;
+    size_t probe(const prop_key& key, flat_type type, uint32_t h) const;
+    flat_slot& insert(const prop_key& key, flat_type type, uint32_t h);
+    void grow(void);
+    void note(const prop_key& key, flat_type type, const void* current);   // Logs key/type on first touch.
+
+    // Every property, in attr_table's save order (strings, ints, floats, bools, each sorted by key).
+    void sorted_entries(std::vector<entry>& order) const;
+    template <typename F>
+    void each(F visit) const;   // visit(type, key, value) for every property, in no particular order.
+
+    std::vector<flat_slot> slots;   // power of two sized, empty until the first insert.
+    size_t used = 0;
+
+    std::shared_ptr<const prop_schema> schema;
+    std::vector<unsigned char>         block;   // schema fields, laid out like schema->prototype.
+
+    prop_write_log* log = nullptr;   // Attached by track, nullptr when nobody is watching.
+};
+
+// C to Instance adaptor to comply with API needs.
+std::string Prop_Serialize(const flat_table& Prop_In, unsigned long& entries, const flat_table* Defaults = nullptr);
+void Prop_Deserialize(flat_table& Prop_In, const std::string& serialized_table, bool Merge = false);
+void Prop_SerializeBinary(const flat_table& Prop_In, prop_dictionary& dict, std::string& out, const flat_table* Defaults = nullptr);
+bool Prop_DeserializeBinary(flat_table& Prop_In, const prop_dictionary& dict, const char* data, size_t size, bool Merge = false);
+void Prop_Diff(const flat_table& Before, const flat_table& After, std::vector<prop_key>& changed);
+bool Prop_Equal(const flat_table& A, const flat_table& B);
+bool Prop_Covers(const flat_table& Prop_In, const flat_table& Defaults);
+void Prop_Track(flat_table& Prop_In, prop_write_log* Log);
+void Prop_LoggedChanges(const flat_table& Prop_In, const prop_write_log& Log, std::vector<prop_key>& changed);
+
+// flat_view ==========================================================================================================
+template <typename T, prop_type Type>
+T& flat_view<T, Type>::operator[](const std::string& key)
+{
+    return *(T*)table->value(key.data(), key.size(), Type, true);
+}
+
+template <typename T, prop_type Type>
+T& flat_view<T, Type>::operator[](const char* key)
+{
+    return *(T*)table->value(key, std::char_traits<char>::length(key), Type, true);
+}
+
+template <typename T, prop_type Type>
+T& flat_view<T, Type>::operator[](const prop_key& key)
+{
+    return *(T*)table->value(key, Type, true);
+}
+
+template <typename T, prop_type Type>
+size_t flat_view<T, Type>::count(const std::string& key) const
+{
+    return static_cast<const flat_table*>(table)->value(key.data(), key.size(), Type) ? 1 : 0;
+}
+
+template <typename T, prop_type Type>
+size_t flat_view<T, Type>::erase(const std::string& key)
+{
+    return table->erase(key.data(), key.size(), Type) ? 1 : 0;
+}
+
+#endif // FLAT_TABLE_H
@@ -0,0 +1,73 @@
+#ifndef PLANO_FLOW_H
+#define PLANO_FLOW_H
+
+/* Flow.h
+ * Running Flow pins (api::FireFlow, api::TickFlow): imperative, Blueprint style execution.
+ *
+ * An execution is a cursor in the graph: a node, the Flow input it came in through, and the node's Execution record
+ * (types::Execution).  Running it calls the node's Execute callback, which answers with a FlowAction: continue from
+ * one of its Flow outputs (the cursor follows the link to the next node), finish, or suspend for a delay, a signal
+ * or a tick.  Latent nodes are state machines: they set Execution::Step before suspending and switch on it when
+ * they're called again, so a suspended execution is only its record: no thread, no stack.
+ *
+ * Records live in one pool (recycled through a free list), and a suspended one sits in exactly one place: the timer
+ * heap, a signal's wait list, or the ready queue for the next tick.  Thousands of them cost a few dozen bytes each,
+ * and a tick only touches the ones that run.
+ *
+ * Execute reads its inputs from the evaluation slots (evaluation.h) and writes its outputs there too, so data flows
+ * in and out of the pure part of the graph: an Execute that ran dirties the steps reading its node, and the next
+ * Execute brings them up to date (EvaluateGraph) before reading.  Nodes are tracked by id, so a node deleted while an
+ * execution waits on it just ends that execution.
+ */
+
+#include <plano_types.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+struct FlowRecord {
+    uintptr_t        Node;          // Id of the node the cursor is on.
+    types::Execution Run;
+    bool             Live = false;  // False while on the free list.
+};
+
+struct FlowState {
+    std::deque<FlowRecord>  Records;                            // A deque: an Execute can start flows while its record is in use.
+    std::vector<uint32_t>   Free;                               // Records to reuse.
+    std::deque<uint32_t>    Ready;                              // Run on the next tick (or this one, if it is running), in order.
+    std::deque<uint32_t>    Later;                              // Woken during a tick (yield, signal): run on the next one.
+    std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                        std::greater<std::pair<double, uint32_t>>> Timers;   // Wake time, record.
+    std::unordered_map<std::string, std::vector<uint32_t>> Waiting; // Signal -> records.
+    size_t   Suspended = 0;                                     // Records in Timers or Waiting.
+    bool     Stale = false;                                     // An Execute wrote outputs that steps read: evaluate before the next.
+    double   Now = 0.0;                                         // The clock of the last tick.
+    bool     Running = false;                                   // Inside TickFlow.
+
+    unsigned long long Built = ~0ull;                           // Structure the link index is for.
+    std::unordered_map<uintptr_t, std::vector<uintptr_t>> Next; // Flow output pin id -> the Flow input pins it links to.
+};
+
+// Starts an execution from a Flow output of a node: -1 for its first one.  It runs on the next tick.
+bool FireFlowOutput(ax::NodeEditor::NodeId id, int output);
+
+// Wakes every execution waiting for the signal (nullptr is ""); they run on the next tick.  Returns how many.
+size_t SignalFlows(const char* signal);
+
+// Runs what's ready at "now": fired, due timers, signalled, yielded.  Returns how many Execute calls it made.
+size_t TickFlows(double now);
+
+// Drops every execution.
+void StopFlows();
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_FLOW_H
@@ -1,13 +1,24 @@
 #ifndef PLANO_INTERNAL_H
 #define PLANO_INTERNAL_H
 #include <plano_api.h>
+#include <internal/journal.h>
+#include <internal/tracking.h>
+#include <internal/evaluation.h>
+#include <internal/batch_evaluation.h>
+#include <internal/flow.h>
+#include <internal/async_evaluation.h>
+#include <internal/profiler.h>
+#include <internal/node_registry.h>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 
 
 namespace plano {
 namespace internal {
 
-extern types::ContextData *s_Session;      // ultimate, global, current session.  managed by public api calls.
-static int context_id = 0; // Tracks unique ImGUI ids for contexts.  Used to seed the ContextData->beginID field.
+extern thread_local types::ContextData *s_Session;  // current session of the calling thread.  managed by public api calls (SetContext, ScopedContext).
+extern std::atomic<int> context_id; // Tracks unique ImGUI ids for contexts.  Used to seed the ContextData->beginID field.
 
 // i/o functions with backend (imgui-node-editor) that generally facilitate serialization of its data.
 bool static_config_save_settings(const char* data, size_t size, ax::NodeEditor::SaveReasonFlags reason, void* userPointer);
@@ -15,16 +26,27 @@ size_t static_config_load_settings(char* data, void* userPointer);
 size_t static_config_load_node_settings(ax::NodeEditor::NodeId nodeId, char* data, void* userPointer);
 bool static_config_save_node_settings(ax::NodeEditor::NodeId nodeId, const char* data, size_t size, ax::NodeEditor::SaveReasonFlags reason, void* userPointer);
 
+// Translation between types::NodeState and the backend's per-node JSON.  Only the node settings callbacks should need these.
+bool        ParseNodeState(const char* data, size_t size, types::NodeState& state); // Returns false if the JSON has no location.
+std::string FormatNodeState(const types::NodeState& state);
+
+// Where a pin lives in s_Nodes.  See ContextData::PinIndex.
+struct PinSlot {
+    size_t Node;    // index into s_Nodes
+    bool   Output;  // Outputs or Inputs
+    size_t Pin;     // index into that vector
+};
+
 } // internal 1 is done
 // still in plano namesapce
 namespace types {
 struct ContextData {
+                   prop_blob_store Blobs;        // Array and blob property values (property_blob.h).  First, so it outlives the nodes.
                                                  // note: nodes carry the pins
     std::vector<types::Node>       s_Nodes;      // s_Nodes is the list of instantiated nodes in the running session
     std::vector<types::Link>       s_Links;      // s_Links is the list of instantiated links in the running session
 
-    std::map<std::string,
-             api::NodeDescription> NodeRegistry; // The Node Registry stores the prototypes.
+    std::shared_ptr<NodeRegistry>  Registry = std::make_shared<NodeRegistry>(); // The node types: their prototypes, schemas and defaults.  Frozen ones are shared with other contexts (node_registry.h).
 
          //std::vector<ImTextureID>  textures;     // Textures "own" the textures used.
                                int s_NextId = 1; // The session needs to keep track of what the next unclaimed ID for nodes, pins & links.
@@ -49,6 +71,25 @@ struct ContextData {
     const char* TexturePath;
                               bool IsProjectDirty;
                               bool m_ShowOrdinals;
+                              bool m_ShowProfile;
+
+    // Id lookup tables for FindNode and FindPin, rebuilt on demand after s_Nodes changes (see InvalidateIdIndex).
+    std::unordered_map<uintptr_t, size_t>             NodeIndex;
+    std::unordered_map<uintptr_t, internal::PinSlot>  PinIndex;
+    std::unordered_map<std::string, std::vector<size_t>> TypeIndex; // Positions in s_Nodes of each type's nodes, in s_Nodes order.
+                              bool IdIndexValid = false;
+
+             internal::JournalState Journal;       // Change journal for incremental saves. See journal.h
+            internal::TrackingState Tracking;      // Property change tracking. See tracking.h
+          internal::EvaluationState Evaluation;    // Graph evaluation. See evaluation.h
+               internal::BatchState Batch;         // Batch evaluation. See batch_evaluation.h
+                internal::FlowState Flow;          // Flow execution. See flow.h
+     internal::AsyncEvaluationState Async;         // Evaluation off the UI thread. See async_evaluation.h
+             internal::ProfilerState Profiler;      // Per node timings. See profiler.h
+                              bool CompressSaves = false;  // Save buffers are block compressed. See compression.h
+                              bool LazyProperties = false; // Loaded nodes keep their properties serialized until first access.
+                              bool BinaryProperties = false; // Snapshots write properties as binary records. See property_codec.h
+                   prop_dictionary PropertyKeys;           // Key dictionary of the project last saved or loaded.  Binary records index into it.
 
     // Constructor
     ContextData(ContextCallbacks Callbacks, const char *texture_path):
@@ -76,6 +117,7 @@ struct ContextData {
         beginID += std::to_string(internal::context_id++);
         IsProjectDirty = false;
         m_ShowOrdinals = false;
+        m_ShowProfile = false;
     };
     // destructor
     ~ContextData()
@@ -97,11 +139,26 @@ int          GetNextId();            // Get an unclaimed ID for runtime ID track
 void         SetNextId(int Id);      // Deserializer will need to bump up the ID after it fills the ContextData with used IDs.
 void         LogRestoredId(int Id);  // Probably a better way to do above, sets next id to 1 + max(id,input).
 
+void         InvalidateIdIndex();    // Call after adding or removing nodes in s_Nodes, so FindNode and FindPin rebuild their tables.
+
 types::Node* FindNode(ax::NodeEditor::NodeId id);    // Convert a NodeId to a Node*
 types::Link* FindLink(ax::NodeEditor::LinkId id);    // Convert a LinkId to a Link*
 types::Pin*  FindPin(ax::NodeEditor::PinId id);      // Convert a PinId to a Pin*
+const PinSlot* FindPinSlot(ax::NodeEditor::PinId id); // Where the pin is in s_Nodes.  Unlike Pin::Node, never stale.
+const std::vector<size_t>& NodesOfType(const std::string& NodeType); // Positions in s_Nodes of every node of the type.
 
         bool IsPinLinked(ax::NodeEditor::PinId id);  //
+        void EraseNode(ax::NodeEditor::NodeId id);   // Removes a node and every link attached to its pins.
+        void EraseLink(ax::NodeEditor::LinkId id);   // Removes a link.
+
+        // Returns the node's properties, parsing them first if they were loaded lazily, or copying the type's
+        // defaults if the node still shares them.  Prefer this over node->Properties everywhere.
+        ::Properties& GetProperties(types::Node& node);
+        bool SharesDefaultProperties(const types::Node& node); // True while the node reads through PropertyDefaults.
+        const ::Properties& PeekProperties(types::Node& node);  // For reading only: a node sharing its defaults stays shared.
+        void ShareDefaultProperties(types::Node& node);        // Drops the node's own table; it reads its type's defaults again.
+        // Parses a properties record into the node's own table.  A delta record applies on top of the type's defaults.
+        bool ParsePropertiesRecord(types::Node& node, const char* data, size_t size, bool binary, bool delta);
         bool isNodeAncestor(types::Node* Ancestor, types::Node* Decendent); // traversal tool
 
         // Draw and Construct tools.  Can we move these?
@@ -0,0 +1,62 @@
+#ifndef PLANO_JOURNAL_H
+#define PLANO_JOURNAL_H
+
+/* Journal.h
+ * Append-only change journal for incremental saves.
+ *
+ * A project file is a full snapshot (SaveNodesAndLinksToBuffer) followed by zero or more journal records.
+ * While the journal is enabled, graph mutations are recorded here instead of re-serializing the whole graph:
+ *   N+  node created        (followed by a node record, see serialization.h)
+ *   N-  node deleted        (followed by the node id)
+ *   L+  link created        (followed by a link record)
+ *   L-  link deleted        (followed by the link id)
+ *   S   node backend state  (followed by the node id and the typed state line)
+ *   P   node properties     (followed by the node id, the properties count and the properties lines)
+ *   C   editor settings     (followed by the s_BlueprintData line)
+ * Structural records are appended as they happen.  State, properties and settings only matter in their
+ * latest form, so they are coalesced and written when the journal is drained.
+ */
+
+#include <imgui_node_editor.h>
+#include <string>
+#include <set>
+
+namespace plano {
+namespace types { struct Node; struct Link; }
+namespace internal {
+
+struct LineReader;
+
+struct JournalState {
+    bool          Enabled = false;
+    bool          Replaying = false;              // Suppresses recording while records are being replayed.
+    std::string   Pending;                        // Structural records that haven't been handed to the host yet.
+    std::set<int> DirtyStates;                    // Node ids whose backend state changed since the last drain.
+    std::set<int> DirtyProperties;                // Node ids whose properties were written since the last drain.
+    bool          DirtySettings = false;          // s_BlueprintData changed since the last drain.
+    size_t        BytesSinceSnapshot = 0;         // Journal bytes the host has appended after the last full snapshot.
+    size_t        CompactionThreshold = 1 << 20;  // Past this many journal bytes, the next drain returns a fresh snapshot.
+};
+
+// Recording hooks.  These do nothing unless the journal is enabled on the current session.
+void JournalNodeCreated(const types::Node& node);
+void JournalNodeDeleted(ax::NodeEditor::NodeId id);
+void JournalLinkCreated(const types::Link& link);
+void JournalLinkDeleted(ax::NodeEditor::LinkId id);
+void JournalNodeStateChanged(ax::NodeEditor::NodeId id);
+void JournalNodePropertiesChanged(ax::NodeEditor::NodeId id);
+void JournalSettingsChanged();
+
+// Returns every record since the last drain (coalesced records last) and clears the pending state.
+std::string DrainJournal();
+
+// Forgets everything recorded so far.  Called whenever a full snapshot is written or loaded.
+void ResetJournal();
+
+// Applies the records remaining in "in" to the current session.  Returns false on a malformed record.
+bool ReplayJournal(LineReader& in);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_JOURNAL_H
@@ -0,0 +1,80 @@
+#ifndef PLANO_MEMO_CACHE_H
+#define PLANO_MEMO_CACHE_H
+
+/* Memo_cache.h
+ * Output cache for pure nodes (NodeDescription::Pure), see evaluation.h.
+ *
+ * An entry maps a key (the node's type, its serialized properties and its input values, as bytes) to the output
+ * values the node computed from it.  Lookups go through a 64 bit hash of the key, but a hit also compares the key
+ * itself, so a collision costs a miss, never a wrong value.
+ *
+ * Entries are kept in least recently Used order and evicted from the back once their total size passes the
+ * capacity.  Sizes are estimates: the key, the Value structs and their strings.  Objects count as a pointer.
+ * Evaluation threads share the cache; every call takes its Lock.
+ *
+ * A key holds an Object input by address, so an entry also keeps those inputs alive: while the entry exists, no
+ * other object can be allocated at an address its key names.
+ */
+
+#include <plano_types.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+class MemoCache {
+public:
+    // Copies the outputs stored for the key into "outputs" and returns true, or returns false on a miss.
+    bool Find(uint64_t hash, const std::string& key, types::Value* outputs, size_t count);
+
+    // Stores outputs for the key, replacing what the hash held, then evicts down to the capacity.  "inputs" are
+    // the values the key was made from; the Object ones are kept with the entry.
+    void Insert(uint64_t hash, const std::string& key, const types::Value* const* inputs, size_t input_count,
+                const types::Value* outputs, size_t count);
+
+    void   SetCapacity(size_t bytes);   // 0 turns the cache off (and empties it).
+    size_t Capacity() const { return Limit; }
+    void   Clear();
+
+    struct Stats {
+        size_t Hits = 0;
+        size_t Misses = 0;
+        size_t Evictions = 0;
+        size_t Entries = 0;
+        size_t Bytes = 0;
+    };
+    Stats GetStats();
+
+    // FNV-1a, 64 bit.
+    static uint64_t Hash(const std::string& key);
+
+private:
+    struct Entry {
+        uint64_t                           Hash;
+        std::string                        Key;
+        std::vector<types::Value>          Outputs;
+        size_t                             Bytes;
+        std::vector<std::shared_ptr<void>> Inputs;   // The Object inputs named in Key.
+    };
+
+    void Evict(size_t limit);
+
+    std::mutex                                               Lock;
+    std::list<Entry>                                         Entries;   // Most recently used first.
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> Index;
+    size_t Limit = 64 * 1024 * 1024;
+    size_t Used = 0;
+    Stats  Counters;
+};
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_MEMO_CACHE_H
@@ -0,0 +1,75 @@
+#ifndef PLANO_NODE_REGISTRY_H
+#define PLANO_NODE_REGISTRY_H
+
+/* Node_registry.h
+ * The node types a context knows (api::RegisterNewNode, api::CreateNodeRegistry).
+ *
+ * A NodeRegistry keeps, for each type, its description and what registering it built: the compiled schema and the
+ * default properties its nodes share.  Types are looked up by name through an open addressing hash index.  Names
+ * are interned (prop_intern), so the index stores no strings of its own and compares a hash before any characters.
+ *
+ * A registry can be frozen and then shared, by reference, among any number of contexts (api::UseNodeRegistry).
+ * A frozen registry is never written again, so contexts on different threads read it without locks, and a new
+ * context costs one pointer instead of a copy of every description.  A context that registers a type of its own on
+ * top of a frozen registry gets a small registry of its own whose Base is the frozen one, and lookups fall through
+ * to it.  Every context starts with an empty registry of its own, so RegisterNewNode works as before.
+ *
+ * The defaults are built with the registry's own blob store current, so blobs they hold don't depend on the context
+ * that happened to be current then.
+ */
+
+#include <plano_api.h>
+#include <internal/property_blob.h>
+#include <internal/property_key.h>
+#include <internal/property_schema.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+// One registered node type.
+struct RegisteredType {
+    api::NodeDescription                Description;
+    prop_key                            Name;       // Description.Type, interned.
+    std::shared_ptr<const prop_schema>  Schema;     // Compiled Description.Schema.  nullptr if it has none.
+    std::shared_ptr<const ::Properties> Defaults;   // Shared copy-on-write by the type's nodes.
+};
+
+} // inner namespace
+
+namespace types {
+
+struct NodeRegistry {
+    prop_blob_store                         Blobs;    // Blobs made by the defaults.  First, so it outlives them.
+    std::deque<internal::RegisteredType>    Types;    // In registration order.  A deque, so entries never move.
+    std::vector<uint32_t>                   Slots;    // Hash index: 1 + index in Types, 0 if empty.  A power of two in size, at most half full.
+    std::vector<uint32_t>                   ByName;   // Indices in Types, sorted by name.
+    std::shared_ptr<const NodeRegistry>     Base;     // Frozen registry this one adds types to, nullptr if none.
+    bool                                    Frozen = false; // No more Add.  Only frozen registries may be shared.
+
+    // The type of that name, here or in Base.  nullptr if neither has it.
+    const internal::RegisteredType* Find(const char* name, size_t length) const;
+    const internal::RegisteredType* Find(const std::string& name) const { return Find(name.data(), name.size()); }
+
+    // Builds the type's schema and defaults and adds it.  The name must be new, Base included.
+    const internal::RegisteredType& Add(api::NodeDescription description);
+
+    size_t Count() const;   // Types, Base included.
+    std::vector<const internal::RegisteredType*> SortedByName() const; // Every type, Base included, by name.
+};
+
+} // types namespace
+
+namespace internal {
+
+// The current context's type of that name, nullptr if it isn't registered.
+const RegisteredType* FindNodeType(const std::string& NodeType);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_NODE_REGISTRY_H
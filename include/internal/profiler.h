@@ -0,0 +1,36 @@
+#ifndef PLANO_PROFILER_H
+#define PLANO_PROFILER_H
+
+/* Profiler.h
+ * Per node timings of evaluation (api::SetProfiling, api::GetNodeProfile).
+ *
+ * Runs only measure: while profiling is on, an evaluation keeps one duration per step (Timings in EvaluationState,
+ * or in the snapshot for EvaluateAsync), written by whichever thread ran the step, and nothing else.  Once the run
+ * is over, on the UI thread, RecordProfile folds them into one NodeProfile per node id and measures the outputs the
+ * step left in its slots.  Ids outlive rebuilds, so a node keeps its numbers when links change.
+ *
+ * Frame draws them over the nodes when the overlay is on (see frame.cpp).
+ */
+
+#include <plano_types.h>
+#include <cstdint>
+#include <unordered_map>
+
+namespace plano {
+namespace internal {
+
+struct ProfilerState {
+    bool Enabled = false;
+    std::unordered_map<uintptr_t, types::NodeProfile> Nodes;   // By node id.
+};
+
+// Adds one call of the node: its duration, and the outputs it produced.
+void RecordProfile(uintptr_t node, double seconds, const types::Value* outputs, size_t count);
+
+// The node's profile, nullptr if it never ran while profiling.
+const types::NodeProfile* FindProfile(uintptr_t node);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_PROFILER_H
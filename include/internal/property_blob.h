@@ -0,0 +1,130 @@
+#ifndef PROPERTY_BLOB_H
+#define PROPERTY_BLOB_H
+
+/* Property_blob.h
+ * Large property values: arrays of ints or floats, and raw byte blobs (curves, lookup tables, small images).
+ *
+ * A prop_blob is a handle to immutable bytes stored out of line and shared by reference count, so copying a
+ * table (copy-on-write defaults, change tracking snapshots) copies handles, never payloads.  Reading is zero-copy:
+ * as<float>() is a span over the stored bytes.  To change a value, assign a new blob.
+ *
+ * Blobs are made in a prop_blob_store, normally the current context's (see prop_blob_store::current), which keeps
+ * one copy of identical payloads: a lookup table shared by a thousand nodes is stored once.
+ *
+ * Arrays are saved as their raw bytes in host order (little endian everywhere plano runs), so floats round-trip
+ * bit for bit.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Read-only view of an array property.
+template <typename T>
+struct prop_span {
+    const T* ptr = nullptr;
+    size_t   count = 0;
+
+    const T* data(void) const { return ptr; }
+    size_t   size(void) const { return count; }
+    bool     empty(void) const { return count == 0; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* begin(void) const { return ptr; }
+    const T* end(void) const { return ptr + count; }
+};
+
+class prop_blob_store;
+
+// Header of a stored payload.  The bytes follow it, 8 byte aligned.
+struct prop_blob_data {
+    std::atomic<uint32_t> refs;
+    uint32_t              hash;
+    size_t                size;
+    prop_blob_store*      store;    // nullptr for blobs made without a store, or whose store is gone.
+
+    const unsigned char* bytes(void) const { return (const unsigned char*)(this + 1); }
+};
+
+class prop_blob {
+public:
+    prop_blob() = default;
+    prop_blob(const prop_blob& other): d(other.d) { if (d) d->refs.fetch_add(1, std::memory_order_relaxed); }
+    prop_blob(prop_blob&& other) noexcept: d(other.d) { other.d = nullptr; }
+    prop_blob& operator=(const prop_blob& other) { prop_blob copy(other); std::swap(d, copy.d); return *this; }
+    prop_blob& operator=(prop_blob&& other) noexcept { std::swap(d, other.d); return *this; }
+    ~prop_blob() { release(); }
+
+    // Copies the bytes into the current store.  Zero bytes give an empty blob.
+    static prop_blob from_bytes(const void* data, size_t size);
+
+    // Same, from an array of ints or floats (or any trivially copyable type).
+    template <typename T>
+    static prop_blob from_array(const T* values, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "arrays hold plain values");
+        return from_bytes(values, count * sizeof(T));
+    }
+    template <typename T>
+    static prop_blob from_array(const std::vector<T>& values) { return from_array(values.data(), values.size()); }
+
+    const unsigned char* data(void) const { return d ? d->bytes() : nullptr; }
+    size_t               size(void) const { return d ? d->size : 0; }
+    bool                 empty(void) const { return size() == 0; }
+
+    // The payload as an array.  Trailing bytes that don't make a whole element are left out.
+    template <typename T>
+    prop_span<T> as(void) const { return { (const T*)data(), size() / sizeof(T) }; }
+
+    bool operator==(const prop_blob& other) const;
+    bool operator!=(const prop_blob& other) const { return !(*this == other); }
+
+private:
+    friend class prop_blob_store;
+    explicit prop_blob(prop_blob_data* adopted): d(adopted) {}
+    void release(void);
+
+    prop_blob_data* d = nullptr;
+};
+
+class prop_blob_store {
+public:
+    prop_blob_store() = default;
+    ~prop_blob_store();     // Blobs still alive keep their bytes; they just stop being shared with new ones.
+    prop_blob_store(const prop_blob_store&) = delete;
+    prop_blob_store& operator=(const prop_blob_store&) = delete;
+
+    // A blob holding a copy of the bytes, or the existing one if an identical payload is already stored.
+    prop_blob intern(const void* data, size_t size);
+
+    size_t count(void) const;    // Distinct payloads alive.
+    size_t bytes(void) const;    // Their total size.
+
+    // The store prop_blob::from_bytes uses on the calling thread.  The public api points it at the current context's.
+    static prop_blob_store* current(void);
+    static void set_current(prop_blob_store* store);
+
+private:
+    friend class prop_blob;
+    void erase(prop_blob_data* blob);
+
+    mutable std::mutex                                  lock;
+    std::unordered_multimap<uint32_t, prop_blob_data*>  blobs;   // by payload hash
+    size_t                                              total = 0;
+};
+
+// Makes a store current on the calling thread until the scope ends, then restores the previous one.
+class prop_blob_scope {
+public:
+    explicit prop_blob_scope(prop_blob_store* store): previous(prop_blob_store::current()) { prop_blob_store::set_current(store); }
+    ~prop_blob_scope() { prop_blob_store::set_current(previous); }
+    prop_blob_scope(const prop_blob_scope&) = delete;
+    prop_blob_scope& operator=(const prop_blob_scope&) = delete;
+
+private:
+    prop_blob_store* previous;
+};
+
+#endif // PROPERTY_BLOB_H
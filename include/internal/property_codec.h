@@ -0,0 +1,75 @@
+#ifndef PROPERTY_CODEC_H
+#define PROPERTY_CODEC_H
+
+/* Property_codec.h
+ * Binary encoding of a properties table, shared by attr_table and flat_table.
+ *
+ * Record layout:
+ *   varint   entry count
+ *   entries  u8 type (prop_type), varint key (index into the file's key dictionary), then the value:
+ *            int, float  4 bytes little endian (floats bit for bit, so they round-trip exactly)
+ *            bool        1 byte
+ *            string      varint length, then the bytes
+ *            arrays, blob varint byte length, then the raw bytes (see property_blob.h)
+ *
+ * Keys are written once per file, in a prop_dictionary, instead of once per property.  Encoding appends to the
+ * caller's buffer and decoding reads straight out of the file buffer, so neither allocates per property
+ * (beyond what the table itself needs to store a new value).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <internal/property_key.h>
+#include <internal/property_schema.h>
+#include <internal/property_blob.h>
+
+// Keys of one save file, in the order they were first written.
+struct prop_dictionary {
+    std::vector<prop_key>                     keys;
+    std::unordered_map<uint32_t, uint32_t>    index;   // prop_key::id -> position in keys
+    std::unordered_map<std::string, uint32_t> names;   // name -> position, for tables keyed by name (attr_table)
+
+    // Position of the key, adding it if it's new.
+    uint32_t add(const prop_key& key);
+    // Same, by name.  Only a name this dictionary hasn't seen yet is interned, so encoding a table doesn't take
+    // prop_intern's global lock once per property.
+    uint32_t add(const std::string& name);
+    void clear(void) { keys.clear(); index.clear(); names.clear(); }
+};
+
+// Writes a record.  Call prop_begin_binary with the entry count, then prop_put_binary once per entry.
+void prop_begin_binary(std::string& out, uint32_t entries);
+void prop_put_binary(std::string& out, prop_dictionary& dict, prop_type type, const prop_key& key, const void* value);
+void prop_put_binary(std::string& out, prop_dictionary& dict, prop_type type, const std::string& name, const void* value);
+
+// Reads a record, entry by entry, without copying anything.
+struct prop_binary_reader {
+    const unsigned char* at;
+    const unsigned char* end;
+    const prop_dictionary& dict;
+
+    prop_binary_reader(const char* data, size_t size, const prop_dictionary& dict):
+        at((const unsigned char*)data), end((const unsigned char*)data + size), dict(dict) {}
+
+    bool begin(uint32_t& entries);                                     // false if the count is malformed.
+    bool next(prop_type& type, const prop_key*& key);                  // false on a bad tag or key index.
+    bool get(int& value);                                              // the value of the entry next() just read.
+    bool get(float& value);
+    bool get(bool& value);
+    bool get(const char*& value, size_t& length);                      // strings, arrays and blobs.
+    bool done(void) const { return at == end; }
+};
+
+// Shortest text that reads back as the same float (strtof).  Used by the text encodings.
+std::string prop_format_float(float value);
+
+// Text encoding type letters: s, i, f, b, and I, F, x for int arrays, float arrays and blobs.  Arrays and blobs
+// are raw: their value line is the byte count, and the bytes themselves (then a newline) follow the type line.
+char      prop_text_letter(prop_type type);
+prop_type prop_text_type(char letter);   // prop_type::empty for an unknown letter.
+inline bool prop_is_raw(prop_type type) { return type >= prop_type::pints && type <= prop_type::pblob; }
+
+#endif // PROPERTY_CODEC_H
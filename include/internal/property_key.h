@@ -0,0 +1,47 @@
+#ifndef PROPERTY_KEY_H
+#define PROPERTY_KEY_H
+
+/* Property_key.h
+ * Interned property names.
+ * Widget code looks the same few property names up every frame, for every node.  Interning a name once gives a
+ * prop_key handle that both property tables accept in place of the string: p.pint[key] instead of p.pint["name"],
+ * with no temporary std::string and (in flat_table) no hashing or string compares.
+ *
+ * Interning is thread safe.  Interned names live until the process exits, so intern names, not arbitrary data.
+ *
+ * Typical use, once per name:
+ *     static const prop_key ButtonData = prop_intern("buttonData");
+ * or inline, where the handle is resolved on first use and cached:
+ *     p.pint[PLANO_PROP_KEY("buttonData")]++;
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct prop_key {
+    uint32_t           id = 0;          // 0 is "no key".  Ids are dense, in interning order.
+    uint32_t           hash = 0;        // prop_hash of the name.
+    const std::string* name = nullptr;  // The interned name.  Stable for the life of the process.
+};
+
+// FNV-1a of the name.  Any table can derive its own slot hash from this without touching the string again.
+inline uint32_t prop_hash(const char* key, size_t length)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Returns the handle of a name, interning it on first sight.  Same name, same handle, from any context or thread.
+prop_key prop_intern(const char* key, size_t length);
+prop_key prop_intern(const char* key);
+prop_key prop_intern(const std::string& key);
+
+// Interns a string literal the first time the expression runs, then reuses the handle.
+#define PLANO_PROP_KEY(literal) ([]() -> const prop_key& { static const prop_key key = prop_intern(literal); return key; }())
+
+#endif // PROPERTY_KEY_H
@@ -0,0 +1,93 @@
+#ifndef PROPERTY_SCHEMA_H
+#define PROPERTY_SCHEMA_H
+
+/* Property_schema.h
+ * Fixed property layouts for node types.
+ * A node type that declares its properties up front (NodeDescription::Schema) gets a prop_schema: every int, float
+ * and bool field has an offset into one contiguous block, and the block with the defaults filled in is kept as a
+ * prototype.  Creating a node of that type copies the prototype instead of running InitializeDefaultProperties.
+ *
+ * flat_table stores schema fields in the block itself.  attr_table has no block and keeps them in its maps; both
+ * accept prop_field handles (p[field]) and string keys alike, and both save schema fields as ordinary properties.
+ * String fields are not part of the block; they're regular properties seeded with their defaults.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <internal/property_key.h>
+
+enum class prop_type : uint8_t {
+    empty = 0,
+    pstring,
+    pint,
+    pfloat,
+    pbool,
+    pints,      // array of int, a prop_blob (see property_blob.h)
+    pfloats,    // array of float, a prop_blob
+    pblob,      // raw bytes, a prop_blob
+};
+
+template <typename T> struct prop_traits;
+template <> struct prop_traits<std::string> { static constexpr prop_type type = prop_type::pstring; };
+template <> struct prop_traits<int>         { static constexpr prop_type type = prop_type::pint; };
+template <> struct prop_traits<float>       { static constexpr prop_type type = prop_type::pfloat; };
+template <> struct prop_traits<bool>        { static constexpr prop_type type = prop_type::pbool; };
+
+struct prop_schema;
+
+// Typed handle to one property of a node type.  Only int, float, bool and std::string fields exist, and using a
+// prop_field<float> where an int is expected doesn't compile.  See prop_schema::field.
+template <typename T>
+struct prop_field {
+    static_assert(prop_traits<T>::type != prop_type::empty, "properties are int, float, bool or std::string");
+    const prop_schema* schema = nullptr;   // Offset is only meaningful for tables built from this schema.
+    prop_key           key;
+    uint32_t           offset = 0;
+};
+
+struct prop_schema_field {
+    prop_key  key;
+    prop_type type;
+    uint32_t  offset;       // Into the block.  Unused for strings.
+};
+
+struct prop_schema {
+    std::vector<prop_schema_field> fields;      // Declaration order.
+    std::vector<std::string>       strings;     // Defaults of the string fields, in the order they appear in fields.
+    std::vector<unsigned char>     prototype;   // The block, with every default written in.
+
+    // Appends a field.  "value" points to an int, float, bool or std::string matching "type".
+    void add(const prop_key& key, prop_type type, const void* value);
+
+    // Field lookup.  Schemas are a handful of fields, so this is a scan over prehashed keys.
+    const prop_schema_field* find(const prop_key& key, prop_type type) const {
+        for (const auto& f : fields)
+            if (f.key.id == key.id && f.type == type)
+                return &f;
+        return nullptr;
+    }
+    const prop_schema_field* find(const char* key, size_t length, uint32_t hash, prop_type type) const {
+        for (const auto& f : fields)
+            if (f.key.hash == hash && f.type == type && f.key.name->size() == length && memcmp(f.key.name->data(), key, length) == 0)
+                return &f;
+        return nullptr;
+    }
+
+    // Resolves a typed handle.  A name the schema doesn't have (or has with another type) gives an unbound handle,
+    // which still works, through a normal key lookup.
+    template <typename T>
+    prop_field<T> field(const char* name) const {
+        prop_field<T> handle;
+        handle.key = prop_intern(name);
+        if (const prop_schema_field* f = find(handle.key, prop_traits<T>::type)) {
+            handle.schema = this;
+            handle.offset = f->offset;
+        }
+        return handle;
+    }
+};
+
+#endif // PROPERTY_SCHEMA_H
@@ -0,0 +1,89 @@
+#ifndef PROPERTY_WRITES_H
+#define PROPERTY_WRITES_H
+
+/* Property_writes.h
+ * Write log of a property table, filled while a node's draw callback runs (see tracking.h).
+ *
+ * Widgets are handed references into the table and write through them later, so a table never sees the writes
+ * themselves, only the accessors that hand the references out.  While a log is attached (attr_table::track,
+ * flat_table::track), every mutable accessor (operator[], erase) notes the key the first time it hands it out,
+ * along with the value it had then.  Afterwards only those keys are compared, whichever node was drawn.
+ * Operations that rewrite the whole table (clear, set_schema, a deseralize or decode that isn't a merge) just set
+ * "everything".
+ *
+ * Writes through map iterators, or through a pointer kept from before the log was attached, aren't noted.
+ */
+
+#include <string>
+#include <vector>
+#include <internal/property_key.h>
+#include <internal/property_schema.h>
+#include <internal/property_blob.h>
+
+struct prop_write {
+    prop_type   type = prop_type::empty;
+    bool        existed = false;   // false if the accessor created the property.
+    prop_key    key;               // flat_table's handle.  attr_table's maps are keyed by name, and fill "name" instead.
+    std::string name;
+    union {
+        int     i;
+        float   f;
+        bool    b;
+    } value = { 0 };               // The value when the key was first handed out: here, in str or in blob.
+    std::string str;
+    prop_blob   blob;
+
+    // "current" points at a value of "type" (int, float, bool, std::string or prop_blob), nullptr if there is none.
+    void save(const void* current) {
+        existed = current != nullptr;
+        if (!current)
+            return;
+        switch (type) {
+            case prop_type::pstring: str = *(const std::string*)current; break;
+            case prop_type::pint:    value.i = *(const int*)current;     break;
+            case prop_type::pfloat:  value.f = *(const float*)current;   break;
+            case prop_type::pbool:   value.b = *(const bool*)current;    break;
+            case prop_type::pints:
+            case prop_type::pfloats:
+            case prop_type::pblob:   blob = *(const prop_blob*)current;  break;
+            default: break;
+        }
+    }
+    bool changed(const void* current) const {
+        if (!existed || !current)
+            return existed != (current != nullptr);
+        switch (type) {
+            case prop_type::pstring: return str != *(const std::string*)current;
+            case prop_type::pint:    return value.i != *(const int*)current;
+            case prop_type::pfloat:  return value.f != *(const float*)current;
+            case prop_type::pbool:   return value.b != *(const bool*)current;
+            case prop_type::pints:
+            case prop_type::pfloats:
+            case prop_type::pblob:   return !(blob == *(const prop_blob*)current);
+            default:                 return false;
+        }
+    }
+};
+
+struct prop_write_log {
+    std::vector<prop_write> writes;         // One per key handed out, in first-touch order.
+    bool                    everything = false;
+
+    void reset(void) { writes.clear(); everything = false; }
+
+    // The entry for key/type, nullptr if it hasn't been handed out yet.  Linear: a callback touches a few keys.
+    prop_write* find(prop_type type, const prop_key& key) {
+        for (auto& w : writes)
+            if (w.key.id == key.id && w.type == type)
+                return &w;
+        return nullptr;
+    }
+    prop_write* find(prop_type type, const std::string& name) {
+        for (auto& w : writes)
+            if (w.type == type && w.name == name)
+                return &w;
+        return nullptr;
+    }
+};
+
+#endif // PROPERTY_WRITES_H
@@ -0,0 +1,94 @@
+#ifndef PLANO_SERIALIZATION_H
+#define PLANO_SERIALIZATION_H
+
+/* Serialization.h
+ * Node and link records of the project text format.
+ * The same records are written by full project snapshots (SaveNodesAndLinksToBuffer) and by the
+ * change journal (journal.h), so both readers and writers live here.
+ *
+ * Readers never throw and never trust the buffer: malformed or truncated input makes them return false.
+ */
+
+#include <plano_types.h>
+#include <string>
+
+namespace plano {
+namespace internal {
+
+// Cursor over a save buffer, one line at a time.
+struct LineReader
+{
+    const char* At;
+    const char* End;
+
+    LineReader(const char* data, size_t size): At(data), End(data + size) {}
+
+    bool   AtEnd() const { return At >= End; }
+    size_t Remaining() const { return (size_t)(End - At); }
+
+    // Reads up to the next '\n', which is consumed but not returned.  A last line without '\n' counts too.
+    bool   ReadLine(const char*& begin, size_t& length);
+    bool   ReadLine(std::string& line);
+
+    // Reads a line that holds exactly one integer (trailing whitespace and '\r' are tolerated).
+    bool   ReadInt(long& value);
+
+    // Takes the next "size" bytes as they are, newlines included.
+    bool   ReadBytes(size_t size, const char*& begin);
+};
+
+// Parses "length" characters as one integer, like LineReader::ReadInt.
+bool         ParseInt(const char* text, size_t length, long& value);
+
+// Key dictionary section, between the settings line and the node count.  Only written when there are keys:
+//   k<key count>
+//   one key per line
+// Binary property records refer to keys by their position here.
+void         WriteKeyDictionary(std::string& out);
+bool         ReadKeyDictionary(LineReader& in);   // Replaces the session's dictionary (empties it if the section is absent).
+
+// Node record layout:
+//   id
+//   type name
+//   pin count
+//   pin ids (inputs first, then outputs)
+//   properties record
+void         WriteNodeRecord(std::string& out, const types::Node& node, bool binary = false);
+
+// Restores a node record into the current session.  "node" gets nullptr if the node type is not registered or
+// its pins don't match the registry (the record is still consumed, and its ids are still reserved).
+bool         ReadNodeRecord(LineReader& in, types::Node** node = nullptr);
+
+// Properties record layout, text:
+//   properties count
+//   properties lines (see Prop_Serialize)
+// or binary (see Prop_SerializeBinary), keys indexing the session's key dictionary:
+//   b<byte count>
+//   the record bytes, then a newline
+// Either may be preceded by a "d" line, making it a delta: only the properties that differ from the node type's
+// defaults (api::NodeDescription).  Nodes that still share their defaults write an empty delta, "d" then "0".
+// Lazily loaded nodes that were never accessed write their original record back verbatim.
+void         WritePropertiesRecord(std::string& out, const types::Node& node, bool binary = false);
+
+// Reads a properties record into "node", or just consumes it if node is nullptr.  With lazy loading on,
+// the record is kept as the node's PropertySpan instead of being parsed.  An empty delta leaves the node sharing its defaults.
+bool         ReadPropertiesRecord(LineReader& in, types::Node* node);
+
+// Link record layout:
+//   id
+//   start pin id
+//   end pin id
+void         WriteLinkRecord(std::string& out, const types::Link& link);
+
+// Restores a link record into the current session.  Links to pins that don't exist (eg. pins of a node
+// type that isn't registered) are dropped.
+bool         ReadLinkRecord(LineReader& in);
+
+// Appends "value\n".
+void         WriteLine(std::string& out, unsigned long long value);
+void         WriteLine(std::string& out, const std::string& value);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_SERIALIZATION_H
@@ -0,0 +1,61 @@
+#ifndef PLANO_TRACKING_H
+#define PLANO_TRACKING_H
+
+/* Tracking.h
+ * Property change tracking.
+ *
+ * Widgets write straight into a node's Properties, through references the table hands out.  While a node's draw
+ * callback runs, its table keeps a write log (property_writes.h): every key an accessor hands out, with the value it
+ * had then.  Afterwards only those keys are compared, for every node drawn, wherever the mouse is.  A difference
+ * bumps the node's generation and the generation of each changed key, marks the project dirty, feeds the journal
+ * and queues the node in the frame's change list.  Nothing is copied for a node its callback only reads.
+ *
+ * A write the log can't see (through a map iterator, or a pointer kept from an earlier frame) is still caught when
+ * ImGui reports the node's widgets as edited, and then counts as a change of every property.
+ *
+ * Writes made outside the draw callbacks (eg. through api::GetNodeProperties) are reported with
+ * api::MarkNodePropertiesChanged.
+ */
+
+#include <imgui_node_editor.h>
+#include <plano_properties.h>
+#include <vector>
+
+namespace plano {
+namespace types { struct Node; }
+namespace internal {
+
+struct TrackingState {
+    unsigned long long Generation = 0;                 // Last generation handed out.
+    unsigned long long Epoch = 1;                      // Current frame, for Node::ChangeEpoch.
+    std::vector<ax::NodeEditor::NodeId> ChangedNodes;  // Nodes whose properties changed during the last Frame().
+    std::vector<ax::NodeEditor::NodeId> Changing;      // Nodes changed since, published by the next EndTrackingFrame.
+    prop_write_log         Writes;                     // What the node being drawn handed out.
+    ::Properties           Shared;                     // What nodes sharing their defaults are drawn with.
+    const ::Properties*    SharedSource = nullptr;     // The defaults Shared is a copy of, nullptr if it's stale.
+    bool                   DrawingShared = false;      // State of the node between Begin and EndNodeProperties.
+    std::vector<prop_key>  Keys;                       // Scratch for the changed keys.
+};
+
+// Frame() calls EndTrackingFrame when it is done drawing the nodes.
+void EndTrackingFrame();
+
+// Brackets a node's draw callback.  BeginNodeProperties returns the table to hand the callback, with the write log
+// attached, and EndNodeProperties records what it changed.  "edited" is whether ImGui saw one of the node's widgets edited.
+::Properties& BeginNodeProperties(types::Node& node);
+void          EndNodeProperties(types::Node& node, bool edited);
+
+// Gives a node that was just created or loaded a fresh generation, so nothing cached for a previous node with
+// the same id still matches.
+void StampNewNode(types::Node& node);
+
+// Records a change.  With keys == nullptr every property of the node counts as changed.
+void NodePropertiesChanged(types::Node& node, const prop_key* keys, size_t count);
+
+// Generation of one property's last change.
+unsigned long long PropertyGeneration(const types::Node& node, const prop_key& key);
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_TRACKING_H
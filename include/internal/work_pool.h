@@ -0,0 +1,70 @@
+#ifndef PLANO_WORK_POOL_H
+#define PLANO_WORK_POOL_H
+
+/* Work_pool.h
+ * Work-stealing thread pool, for parallel graph evaluation (see evaluation.h).
+ *
+ * A batch is a known number of tasks (plain integers) run by one work function.  Tasks may push more tasks while
+ * they run, which is how a node hands its dependents over once they're ready.  Every thread has its own deque:
+ * it pushes and pops at the back (the task it just made ready is the one whose inputs are still in cache) and,
+ * when it runs dry, steals from the front of the others'.  The thread that calls Finish works too, as thread 0,
+ * and is the only one that runs tasks pushed as main-thread-only.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+class WorkPool {
+public:
+    typedef void (*WorkFunction)(void* user, uint32_t task, unsigned thread);
+
+    explicit WorkPool(unsigned threads);   // Counting the calling thread, so 1 starts no threads of its own.
+    ~WorkPool();
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    unsigned Threads() const { return (unsigned)Queues.size(); }
+
+    // A batch: Start, Push the tasks that are ready, then Finish, which returns once "total" tasks have run.
+    void Start(size_t total, WorkFunction work, void* user);
+    void Push(unsigned thread, uint32_t task, bool main_only = false);   // "thread" is the caller's (0 outside of work).
+    void Finish();
+
+private:
+    struct Queue {
+        std::mutex           Lock;
+        std::deque<uint32_t> Tasks;
+    };
+
+    bool Take(unsigned thread, uint32_t& task);
+    void RunTask(unsigned thread, uint32_t task);
+    void WorkerLoop(unsigned thread);
+
+    std::vector<std::unique_ptr<Queue>> Queues;   // One per thread, 0 being the one that calls Finish.
+    Queue                    MainOnly;
+    std::vector<std::thread> Workers;
+
+    WorkFunction Work = nullptr;
+    void*        User = nullptr;
+    std::atomic<size_t> Pending { 0 };   // Tasks of the batch not finished yet.
+    std::atomic<size_t> Queued  { 0 };   // Tasks sitting in Queues.
+    std::atomic<size_t> MainQueued { 0 }; // Tasks sitting in MainOnly.
+
+    std::mutex              Lock;        // Guards sleeping, with Wake.
+    std::condition_variable Wake;
+    bool                    Quit = false;
+};
+
+} // inner namespace
+} // outer namespace
+
+#endif // PLANO_WORK_POOL_H
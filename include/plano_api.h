@@ -20,27 +20,163 @@ namespace types {
 namespace api {    
     struct NodeDescription; // Forward declaration.
     struct PinDescription; // Forward declaration.
+    struct PropertyDescription; // Forward declaration.
 
     // Plano Context Management 
-    // These calls manipulate the global context variable, on which the other API calls operate on.
+    // These calls manipulate the current context, on which the other API calls operate on.  Each thread has its own current context.
+    // Distinct contexts can be used from distinct threads at the same time: load, evaluate and save one project per thread, for instance.  One context must not be used from two threads at once.
+    // The exceptions are Frame, CreateContext, DestroyContext and SetContext, which go through ImGui and the node editor, whose current contexts are process wide: keep those on one thread (the UI's).
+    // Evaluation threads (SetEvaluationThreads, EvaluateAsync) have no current context, only the context's blob store: Evaluate callbacks must not call the plano API.
     types::ContextData* CreateContext(const types::ContextCallbacks& Config, const char *texture_path );
-    const types::ContextData* GetContext();
-    void                SetContext(types::ContextData* context);
+    const types::ContextData* GetContext();                             // The calling thread's.
+    void                SetContext(types::ContextData* context);        // For the calling thread, and makes it the node editor's current editor.
     void                DestroyContext(types::ContextData*);
 
+    // Makes a context current on the calling thread until the scope ends, then restores the previous one.  Unlike SetContext it leaves the node editor alone, so worker threads can use it.
+    class ScopedContext {
+    public:
+        explicit ScopedContext(types::ContextData* context);
+        ~ScopedContext();
+        ScopedContext(const ScopedContext&) = delete;
+        ScopedContext& operator=(const ScopedContext&) = delete;
+    private:
+        types::ContextData* Previous;
+        prop_blob_store*    PreviousBlobs;
+    };
+
     // Drawing Subsystem Routines 
     void Frame(void);      // Draws nodes and handles interactions. Call in your draw loop.
 
     // Node Prototype Registration     
     void RegisterNewNode(NodeDescription NewDescription);    // Call this to make the system aware of a node type. Called once per node type.
 
+    // Shared Node Registries
+    // Registering every node type in every context copies every description, schema and set of defaults.  Register them once into a registry instead, freeze it, and hand it to each context: they all read the one copy, from any thread, and a new context costs nothing per node type.
+    std::shared_ptr<types::NodeRegistry> CreateNodeRegistry();                       // An empty registry.  Needs no context.  Freed with the last context using it and your last reference.
+    void  RegisterNewNode(types::NodeRegistry* registry, NodeDescription NewDescription); // Same as above, into the registry.  Only until it's frozen.
+    void  FreezeNodeRegistry(types::NodeRegistry* registry);                          // No more types after this.  Only frozen registries can be used by contexts.
+    void  UseNodeRegistry(std::shared_ptr<types::NodeRegistry> registry);              // The current context's node types become the registry's, by reference.  Call it before adding or loading nodes.  Types registered in the context afterwards are its own, on top of the registry's.
+    size_t GetNodeTypeCount();                                                        // Node types the current context knows.
+
     // Project Dirty Flag
     bool IsProjectDirty(); // If true, something in the project has changed that will be lost if not saved. If false, no changes since last load.  Dirty Flags are stored "per-context".  This reads the current context's flag.
     void ClearProjectDirtyFlag(); // You call this after saving, which makes the dirty flag false for the current context.
 
     // Project Save and Load functions
     char* SaveNodesAndLinksToBuffer(size_t* size);           // Serialize the graph to a char*.  Writes length to "size". You must manually free the return value with delete.
-    void  LoadNodesAndLinksFromBuffer(const size_t in_size,  const char *buffer);  // Opposite of above.  
+    bool  LoadNodesAndLinksFromBuffer(const size_t in_size,  const char *buffer);  // Opposite of above.  Also replays any journal records appended after the snapshot.  Returns false (and loads nothing) if the buffer is malformed.
+
+    // Incremental Save (Journal) functions
+    // With the journal enabled, edits are recorded as compact records instead of re-serializing the whole graph.
+    // Write a snapshot with SaveNodesAndLinksToBuffer, then on every autosave append the output of SaveJournalToBuffer to the same file.
+    void  EnableJournal(bool enable);                        // Off by default.  Per-context, like the dirty flag.
+    char* SaveJournalToBuffer(size_t* size, bool* is_snapshot); // Records since the last call.  Append them to the file.  If the journal outgrew the compaction threshold, this returns a full snapshot instead and sets is_snapshot: replace the file with it.  Free with delete.
+    void  SetJournalCompactionThreshold(size_t bytes);       // Journal size (since the last snapshot) that triggers compaction.  Default 1MB.
+
+    // Project Compression
+    void  SetSaveCompression(bool enable);                   // Off by default.  Save calls emit block compressed frames.  Loading detects compression by itself.  Keep the setting fixed while appending journals to a file.
+
+    // Binary Properties
+    void  SetBinaryProperties(bool enable);                  // Off by default.  Snapshots store properties as compact binary records (keys written once per file, floats bit exact) inside the usual text layout.  Loading reads either kind.
+
+    // Lazy Property Loading
+    void  SetLazyPropertyLoading(bool enable);               // Off by default.  Loaded nodes keep their property lines unparsed until something reads them, and untouched nodes save those lines back verbatim.
+    Properties* GetNodeProperties(ax::NodeEditor::NodeId id); // A node's properties (parsed on demand).  nullptr if there is no such node.
+
+    // Property Change Tracking
+    // Generations only grow: keep the one you computed from, and if it differs the next time you look, recompute.
+    const std::vector<ax::NodeEditor::NodeId>& GetChangedNodes(); // Nodes whose properties changed during the last Frame(), including marks made before it.  Ids may belong to nodes deleted since.
+    unsigned long long GetNodePropertyGeneration(ax::NodeEditor::NodeId id);                   // Changes with every write to the node's properties.  0 if there is no such node.
+    unsigned long long GetNodePropertyGeneration(ax::NodeEditor::NodeId id, const char* key); // The same, for one property.
+    void MarkNodePropertiesChanged(ax::NodeEditor::NodeId id, const char* key = nullptr);     // Report a write made outside DrawAndEditProperties (eg. through GetNodeProperties).  No key means any property may have changed.
+
+    // Array and Blob Properties
+    // p.pints["key"], p.pfloats["key"] and p.pblob["key"] hold prop_blob handles (see property_blob.h): assign prop_blob::from_array(...) to set one, read with .as<float>().
+    void  GetPropertyBlobUsage(size_t* count, size_t* bytes); // Distinct array and blob payloads the current context stores, and their size.  Identical values are stored once.
+
+    // Property Schemas
+    // Node types that fill in NodeDescription::Schema get typed handles to their properties: resolve one once, then p[handle] in the draw callback.
+    const prop_schema* GetPropertySchema(const std::string& NodeType); // nullptr if the type isn't registered or has no schema.
+    template <typename T>
+    prop_field<T> GetPropertyField(const std::string& NodeType, const char* Name) { // T is int, float, bool or std::string.  Works (slower) even if the schema lacks the field.
+        const prop_schema* schema = GetPropertySchema(NodeType);
+        if (schema)
+            return schema->field<T>(Name);
+        prop_field<T> unbound;
+        unbound.key = prop_intern(Name);
+        return unbound;
+    }
+
+    // Property Columns
+    // One property across every node of a type, as parallel arrays, for analysis and batch edits.  Schema fields are
+    // read at their fixed offset (with PLANO_FLAT_PROPERTIES), and nodes still sharing their type's defaults are read without copying them.
+    template <typename T>
+    struct PropertyColumn {
+        std::vector<ax::NodeEditor::NodeId> Ids;     // In s_Nodes order.
+        std::vector<T>                      Values;  // Values[i] belongs to Ids[i].
+    };
+    template <typename T> // T is int, float, bool or std::string, as for GetPropertyField.
+    size_t QueryPropertyColumn(const std::string& NodeType, const prop_field<T>& Field, PropertyColumn<T>& Column); // Replaces Column's contents.  Nodes without the property are left out.  Returns the row count.
+    template <typename T>
+    size_t SetPropertyColumn(const std::string& NodeType, const prop_field<T>& Field, const PropertyColumn<T>& Column); // Writes Values[i] to node Ids[i], skipping ids that aren't of NodeType.  Returns how many values changed; those are tracked like widget edits.
+    template <typename T>
+    size_t FillPropertyColumn(const std::string& NodeType, const prop_field<T>& Field, const T& Value); // Writes Value to every node of the type.  Same return value.
+
+    // Graph Evaluation
+    // Node types with an Evaluate callback compute their output pins from their inputs and properties.  Evaluation is headless: it doesn't need Frame().
+    // Values flow along links between pins of the same type; Flow links order nothing here.
+    // Evaluation is incremental: only nodes whose properties, unlinked inputs or incoming links changed since the last run (and the nodes downstream of them) run again.  The rest keep their outputs.
+    bool  Evaluate();                                                   // Runs every such node that needs it, upstream nodes first.  Returns false if links form a cycle: the nodes on it are skipped.
+    const types::Value* GetPinValue(ax::NodeEditor::PinId id);          // An output pin's value from the last Evaluate, or the value an input pin receives.  nullptr if the pin doesn't exist or carries no value.
+    void  SetPinValue(ax::NodeEditor::PinId id, const types::Value& value); // The value an unlinked input pin receives.  Defaults to its type's zero value.
+    void  MarkNodeForEvaluation(ax::NodeEditor::NodeId id);             // Runs the node (and everything downstream) on the next Evaluate, eg. when its Evaluate reads something outside the graph.  Property writes made outside the draw callbacks also need MarkNodePropertiesChanged.
+    size_t GetLastEvaluationCount();                                    // How many nodes the last Evaluate (or slice) ran.
+    bool  EvaluateSlice(double milliseconds);                           // Evaluate, a slice at a time: runs nodes (at least one) until the time is up, then returns; a node that started finishes, so a slow one overruns it.  The next call goes on from there, edits included.  Nodes Frame() last showed on screen, and the nodes feeding them, run first.  True once every node is up to date.  False if links form a cycle, like Evaluate, so a loop waiting for true should also stop once GetLastEvaluationCount() is 0.
+    void  SetEvaluationThreads(unsigned count);                         // Threads Evaluate uses, counting the caller.  1 (the default) runs serially.  Results don't depend on it, as long as Evaluate callbacks only use their arguments (they must not call the plano API).
+
+    // Asynchronous Evaluation
+    // EvaluateAsync snapshots what Evaluate would run (the nodes' properties and input values as they are now) and runs it on a background thread, so a heavy graph doesn't hold up Frame().  Editing goes on meanwhile and shows in the next snapshot.
+    // Results are published all at once on this thread: Frame() does it, PollEvaluation does it without drawing.  Until then GetPinValue returns the previous ones.  Evaluate callbacks must be safe to call from another thread, and must not call the plano API.
+    bool  EvaluateAsync();                                              // Starts a run, cancelling the one in flight (the nodes it would have run go in this one).  Returns false if links form a cycle.  Runs like Evaluate, right here, if a node that has to run is MainThreadOnly.
+    bool  PollEvaluation();                                             // Publishes the run if it finished.  True if it did.
+    bool  IsEvaluating();                                               // A run was started and isn't published yet.
+    void  WaitForEvaluation();                                          // Blocks until the run finishes, then publishes it.
+    void  CancelEvaluation();                                           // Drops the run in flight.  The nodes it would have run go in the next Evaluate or EvaluateAsync.
+
+    // Profiling
+    // While on, every Evaluate call (from Evaluate and EvaluateAsync, memo hits included) is timed and its outputs measured, per node.  It costs two clock reads per call.
+    void  SetProfiling(bool enabled);                                   // Off by default.
+    bool  GetNodeProfile(ax::NodeEditor::NodeId id, types::NodeProfile& profile); // False if the node hasn't run while profiling.
+    void  ResetProfiles();                                              // Forgets every measurement.
+    void  ShowProfileOverlay(bool show);                                // Frame() tints each node on screen from green to red by its average time, next to the slowest one's, and labels it with that time.
+
+    // Memoization
+    // A Pure node that has to run looks for its type, properties and input values in a cache first, and only calls Evaluate if they are new.  Object inputs count by pointer, and the cache holds a reference to them while it keeps their entry.
+    void  SetMemoCapacity(size_t bytes);                                // Memory the cache may use (estimated).  Least recently used outputs go first.  Default 64MB.  0 turns it off.
+    void  ClearMemoCache();                                             // Drops every entry, eg. to free the memory.  The counters keep going.
+    void  GetMemoStats(size_t* hits, size_t* misses, size_t* evictions, size_t* entries, size_t* bytes); // Since the context was created.  Any pointer may be nullptr.
+
+    // Batch Evaluation
+    // Runs the graph over many records at once: Bool, Int and Float pins carry one value per record, String and Object pins keep the values of the last Evaluate.
+    // Node types with EvaluateBatch get whole columns; the rest are called once per record.  Batches always run every node, on the calling thread.
+    template <typename T> // T is bool, int or float: the pin's type.
+    bool  SetPinBatch(ax::NodeEditor::PinId id, const T* values, size_t count); // The values an unlinked input pin receives, one per record (copied).  Inputs without them repeat their SetPinValue value.  False if the pin isn't an input of that type.
+    void  ClearPinBatches();                                            // Forgets every SetPinBatch.
+    bool  EvaluateBatch(size_t count);                                  // Runs "count" records.  Returns false if links form a cycle (the nodes on it are skipped), or without running if a SetPinBatch holds fewer values.
+    template <typename T>
+    const T* GetPinBatch(ax::NodeEditor::PinId id);                     // A pin's values from the last EvaluateBatch, one per record.  nullptr if the pin isn't of type T, or nodes or links changed since.
+    void  RegisterBuiltinNodes(types::NodeRegistry* registry = nullptr); // Registers "Float Add", "Int Less", "Float Select", "Bool And"... (Add, Subtract, Multiply, Divide, Min, Max, Less, Greater, Equal and Select for Float and Int, And/Or/Not for Bool), whose batches use SIMD kernels, and the flow nodes "Branch", "Delay", "Wait For Signal" and "Set Timer".  Call once per context, or once into a shared registry.
+    const char* GetBatchKernelSet();                                    // The instruction set the kernels use on this CPU: "avx2", "sse2" or "scalar".
+
+    // Flow Execution
+    // Flow pins run imperatively, Blueprint style: a flow starts at a node's Flow output, follows the link to the next node and runs its Execute, which sends it on through one of its own Flow outputs, ends it, or suspends it.
+    // Suspended flows (FlowAction::Sleep, WaitFor, NextTick) hold no thread; thousands of them are cheap.  Latent nodes are state machines over Execution::Step, see plano_types.h.
+    bool  FireFlow(ax::NodeEditor::NodeId id, int output = -1);         // Starts a flow from one of the node's Flow outputs (index in its Outputs, -1 for the first), eg. an event node's.  It runs on the next TickFlow, or later in the current one if called from an Execute.  False if the node has no such pin.
+    size_t FireFlowEvent(const std::string& NodeType);                  // FireFlow for every node of the type.  Returns how many there were.
+    size_t SignalFlow(const char* signal);                              // Wakes the flows waiting for the signal; they go on at the next TickFlow.  Returns how many.
+    size_t TickFlow(double now);                                        // Call every frame with the host's clock in seconds.  Runs what is due: fired flows, delays that ran out, signalled and yielded flows.  Returns how many Execute calls it made.
+    size_t GetFlowCount();                                              // Flows alive: about to run or suspended.
+    void  StopFlows();                                                  // Ends every flow.
 
     // Node Description Struct
     // Think of this as an application you fill out that describes a node type.  Register with RegisterNewNode().
@@ -49,11 +185,18 @@ namespace api {
         std::vector<PinDescription> Inputs;     // Input pin descriptions.  Element 0 is at the top left of the node 
         std::vector<PinDescription> Outputs;    // Output pin descriptions. Element 0 is at the top right of the node
         ImColor Color = ImColor(255, 255, 255); // The style color added at the top of the node
+        std::vector<PropertyDescription> Schema; // Optional.  The node's properties, declared up front: defaults become a prototype that new nodes copy, and fields get fixed offsets (see GetPropertyField).
         
         // NodeDescrption Function Pointers
         // You must implement these per node to define widget behavior and values.  See Nodos project for examples.
-        void (*InitializeDefaultProperties)(Properties&); // Set default values for node widget values. Called when constructing a fresh node at runtime (not deserialization).        
+        void (*InitializeDefaultProperties)(Properties&) = nullptr; // Set default values for node widget values. Called once, by RegisterNewNode, after the Schema defaults.  May be nullptr if the Schema covers it.
+                                                                    // Nodes share the result until their first write, and saves only store what differs from it, so changing the defaults changes saved nodes that kept them.
         void (*DrawAndEditProperties)(Properties&);       // Called when it is time to draw the node's widgets.  Restore, edit and save the widget values in the properties table.
+        void (*Evaluate)(const Properties&, const types::Value* const* Inputs, types::Value* Outputs) = nullptr; // Optional.  Computes the output pins from the input pins (in Inputs/Outputs order) and the properties.  See api::Evaluate.
+        void (*EvaluateBatch)(const Properties&, const types::ValueSpan* Inputs, const types::ValueSpan* Outputs) = nullptr; // Optional.  Evaluate over a whole batch: write Outputs[i].As<T>()[0..Count).  Without it, batches call Evaluate once per record.
+        types::FlowAction (*Execute)(types::Execution& Run, const Properties&, const types::Value* const* Inputs, types::Value* Outputs) = nullptr; // Optional.  Runs when a flow comes into one of the node's Flow inputs and says where it goes next (see api::TickFlow).  Reads and writes the same pin values as Evaluate.
+        bool MainThreadOnly = false;                      // Evaluate only runs on the thread that called api::Evaluate (eg. it uses ImGui or a graphics API).
+        bool Pure = false;                                // Evaluate's outputs depend on nothing but its properties and inputs, so api::Evaluate can reuse them (see SetMemoCapacity).  Worth it for costly nodes.
     };
 
     // Pin Description Struct
@@ -67,6 +210,24 @@ namespace api {
             DataType(DataType){};
     };
 
+    // Property Description Struct
+    // One entry of NodeDescription::Schema: a name, a type (Int, Float, Bool or String) and a default value.
+    struct PropertyDescription {
+        std::string Name;
+        plano::types::PinType DataType;
+        int         DefaultInt = 0;
+        float       DefaultFloat = 0.0f;
+        bool        DefaultBool = false;
+        std::string DefaultString;
+
+        // Constructors.  The type follows the default's type.
+        PropertyDescription(std::string Name, int Default):         Name(Name), DataType(plano::types::PinType::Int), DefaultInt(Default) {};
+        PropertyDescription(std::string Name, float Default):       Name(Name), DataType(plano::types::PinType::Float), DefaultFloat(Default) {};
+        PropertyDescription(std::string Name, bool Default):        Name(Name), DataType(plano::types::PinType::Bool), DefaultBool(Default) {};
+        PropertyDescription(std::string Name, const char* Default): Name(Name), DataType(plano::types::PinType::String), DefaultString(Default) {};
+        PropertyDescription(std::string Name, std::string Default): Name(Name), DataType(plano::types::PinType::String), DefaultString(Default) {};
+    };
+
 } // end api namespace
 } // end plano namespace
 #endif // PLANO_API_H
@@ -0,0 +1,85 @@
+#ifndef PLANO_BENCH_H
+#define PLANO_BENCH_H
+/*
+* Plano Bench - serializer benchmark and loader fuzzing for host applications.
+*
+* These calls operate on the current context (see plano::api::SetContext), just like the rest of the API.
+* Nothing here touches the editor or ImGui, so a headless host can drive it from a command line tool:
+*
+*   plano::bench::RegisterBenchmarkNodes();
+*   plano::bench::SyntheticProject project;
+*   project.NodeCount = 100000;
+*   plano::bench::SerializerStats stats = plano::bench::BenchmarkSerializer(project, plano::bench::Format::Text);
+*
+* Allocation counts need plano's global operator new/delete hooks; build bench.cpp with
+* PLANO_BENCH_COUNT_ALLOCATIONS defined to get them (they stay 0 otherwise).
+*/
+#include <cstddef>
+
+namespace plano {
+namespace bench {
+
+    // Shape of a generated project.
+    struct SyntheticProject {
+        size_t   NodeCount = 1000;         // 1k .. 1M is the intended range.
+        float    LinksPerNode = 1.0f;      // Average links ending at a node.  Links only go "forward", so the graph stays acyclic.
+        int      ExtraProperties = 0;      // Properties added to each node on top of its type's defaults, of mixed types.
+        unsigned Seed = 1;
+    };
+
+    // Save formats to measure.
+    enum class Format {
+        Text,            // SaveNodesAndLinksToBuffer as is.
+        Compressed,      // With SetSaveCompression.
+        TextLazyLoad,    // Text, loaded with SetLazyPropertyLoading.
+        Binary,          // With SetBinaryProperties.
+    };
+
+    struct SerializerStats {
+        size_t Nodes = 0;
+        size_t Links = 0;
+        size_t Bytes = 0;               // Size of the saved buffer.
+        double SaveSeconds = 0.0;       // Best of the iterations.
+        double LoadSeconds = 0.0;       // Best of the iterations.
+        double SaveMBPerSecond = 0.0;
+        double LoadMBPerSecond = 0.0;
+        size_t SaveAllocations = 0;     // Per iteration.  See PLANO_BENCH_COUNT_ALLOCATIONS.
+        size_t LoadAllocations = 0;
+        size_t PeakResidentBytes = 0;   // Process high water mark after the run.  0 if the platform doesn't say.
+        bool   RoundTrip = false;       // Saving the loaded project reproduced the original buffer.
+    };
+
+    struct FuzzStats {
+        size_t Runs = 0;
+        size_t Accepted = 0;            // Loader returned true.
+        size_t Rejected = 0;            // Loader returned false.
+        size_t Exceptions = 0;          // Loader threw.  Anything but 0 is a loader bug.
+    };
+
+    // attr_table vs flat_table on the access pattern of widget code: repeated lookups of a few keys per node.
+    struct PropertyTableStats {
+        double InsertSeconds = 0.0;      // Building "tables" tables of "keys" properties each.
+        double LookupSeconds = 0.0;      // "lookups" operator[] calls on existing keys, spread over the tables.
+        double KeyLookupSeconds = 0.0;   // The same lookups with interned keys (prop_key).
+        double SerializeSeconds = 0.0;   // serialize + deseralize of every table.
+    };
+
+    // Registers a small set of test node types ("Bench Source", "Bench Math", "Bench Text", "Bench Sink") in the current context.
+    // Source and Math declare a property schema, Text and Sink set their defaults in InitializeDefaultProperties.
+    void RegisterBenchmarkNodes();
+
+    // Replaces the current context's graph with a generated one, using every node type in the registry.
+    void GenerateSyntheticProject(const SyntheticProject& project);
+
+    // Generates the project, then times saving and loading it "iterations" times.  The current context ends up holding the loaded project.
+    SerializerStats BenchmarkSerializer(const SyntheticProject& project, Format format, int iterations = 3);
+
+    // Loads "iterations" mutated copies of "buffer" (bit flips, truncation, dropped/duplicated lines, garbage numbers) into the current context.
+    FuzzStats FuzzLoader(const char* buffer, size_t size, size_t iterations, unsigned seed = 1);
+
+    // Times the same workload on both property tables, whichever one Properties is.
+    void BenchmarkPropertyTables(size_t tables, size_t keys, size_t lookups, PropertyTableStats& attr, PropertyTableStats& flat);
+
+} // end bench namespace
+} // end plano namespace
+#endif // PLANO_BENCH_H
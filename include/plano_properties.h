@@ -11,7 +11,11 @@
 * Your Burden:
 * If you want to use widgets inside your nodes, you should use properties to track the data.
 * Plano comes with a simple & slow implementation to get you off the ground (attr_table).  If you have perf
-* problems, re-implement the Properties implementation. 
+* problems, re-implement the Properties implementation, or define PLANO_FLAT_PROPERTIES (for every translation unit)
+* to use flat_table: same interface and file format as attr_table, but one flat hash table per node instead of four maps.
+* 
+* Both tables also accept interned keys (internal/property_key.h): resolve a name once with prop_intern("name") or
+* PLANO_PROP_KEY("name") and index with the handle, p.pint[key], to skip building and comparing strings every frame.
 * 
 * Properties will only make sense if they are serialized and deserialized.  When you call these things:
 * plano::api::LoadNodesAndLinksFromBuffer()
@@ -21,8 +25,13 @@
 */
 
 // This area lets you define the datatype for properties.
+#ifdef PLANO_FLAT_PROPERTIES
+#include <internal/flat_table.h>
+typedef flat_table Properties;
+#else
 #include <internal/attribute.h>
 typedef attr_table Properties;
+#endif
 
 
 #endif
\ No newline at end of file
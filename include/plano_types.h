@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include <plano_properties.h>
 
@@ -17,6 +18,10 @@ namespace types {
 // This is a forward declaration.
 struct ContextData;
 
+// A set of node types that contexts can share (api::CreateNodeRegistry).
+// This is a forward declaration.
+struct NodeRegistry;
+
 enum class PinType
 {
     Flow,
@@ -41,6 +46,78 @@ enum class NodeType
 
 struct Node;
 
+// A pin's value, as evaluation passes it from node to node (see api::Evaluate).  The member matching Type holds it.
+struct Value
+{
+    PinType     Type = PinType::Flow;   // Flow, Function and Delegate pins carry no value.
+    bool        Bool = false;
+    int         Int = 0;
+    float       Float = 0.0f;
+    std::string String;
+    std::shared_ptr<void> Object;       // Whatever the node types that Object pins connect agree on.
+
+    Value() = default;
+    explicit Value(PinType type): Type(type) {}
+    Value(bool value):               Type(PinType::Bool), Bool(value) {}
+    Value(int value):                Type(PinType::Int), Int(value) {}
+    Value(float value):              Type(PinType::Float), Float(value) {}
+    Value(const char* value):        Type(PinType::String), String(value) {}
+    Value(std::string value):        Type(PinType::String), String(std::move(value)) {}
+    Value(std::shared_ptr<void> value): Type(PinType::Object), Object(std::move(value)) {}
+};
+
+// One pin's values across a batch of records (api::EvaluateBatch).  Bool, Int and Float pins hold Count values
+// (bools, ints or floats, 32 byte aligned) at Data.  Other pins have one value for the whole batch, at Uniform.
+struct ValueSpan
+{
+    PinType      Type = PinType::Flow;
+    size_t       Count = 0;
+    void*        Data = nullptr;
+    const Value* Uniform = nullptr;
+
+    template <typename T> T* As() const { return static_cast<T*>(Data); }
+};
+
+// What the profiler measured of one node (api::GetNodeProfile).
+struct NodeProfile
+{
+    double Last = 0.0;      // Seconds the last Evaluate call took.
+    double Average = 0.0;   // Seconds, moving average: each call weighs 1/10.
+    double Total = 0.0;     // Seconds, every call.
+    size_t Calls = 0;
+    size_t Bytes = 0;       // Output values the last call produced: 1 per Bool, 4 per Int or Float, a String's length, a pointer per Object.
+};
+
+// A flow's stay in one node (NodeDescription::Execute, api::TickFlow).  Step is 0 when the flow comes in; a latent
+// node sets it before it suspends and switches on it when Execute is called again.  Time, Counter and State are the
+// node's to keep anything else in until the flow leaves.
+struct Execution
+{
+    int       Input = 0;       // The Flow input the flow came in through (index in the node's Inputs).
+    int       Step = 0;
+    int       Fork = -1;       // Set it to one of the node's Flow outputs to start a second flow there, besides what Execute returns.
+    double    Now = 0.0;       // The clock of this tick.
+    double    Time = 0.0;
+    int       Counter = 0;
+    std::shared_ptr<void> State;
+};
+
+// What Execute wants next.
+struct FlowAction
+{
+    enum Kind { Finish, Then, Delay, Wait, Yield };
+    Kind        What = Finish;
+    int         Output = -1;        // Then: the Flow output the flow leaves through (index in the node's Outputs).
+    double      Seconds = 0.0;      // Delay: call Execute again this much later.
+    const char* Signal = nullptr;   // Wait: call Execute again once api::SignalFlow sends this (copied on return).
+
+    static FlowAction End()                       { return FlowAction(); }
+    static FlowAction Continue(int output)        { FlowAction a; a.What = Then; a.Output = output; return a; }
+    static FlowAction Sleep(double seconds)       { FlowAction a; a.What = Delay; a.Seconds = seconds; return a; }
+    static FlowAction WaitFor(const char* signal) { FlowAction a; a.What = Wait; a.Signal = signal; return a; }
+    static FlowAction NextTick()                  { FlowAction a; a.What = Yield; return a; }
+};
+
 struct Pin
 {
     ax::NodeEditor::PinId   ID;
@@ -55,6 +132,18 @@ struct Pin
     }
 };
 
+// The backend's (imgui-node-editor) per-node data: where the node is and how big its group is.
+// The backend speaks JSON about it; plano keeps it typed and only translates inside the settings callbacks.
+struct NodeState
+{
+    ImVec2 Location;
+    ImVec2 Size;
+    ImVec2 GroupSize;
+    bool   HasLocation  = false; // Each field is only valid if the backend wrote it.
+    bool   HasSize      = false;
+    bool   HasGroupSize = false;
+};
+
 struct Node
 {
     ax::NodeEditor::NodeId ID;
@@ -66,9 +155,28 @@ struct Node
     NodeType Type;
     ImVec2 Size;
 
-    std::string State;      // State is buffer to store the backend's node specific data between frames, basically.  It mostly stores the node's position.
+    NodeState   State;      // State is the backend's node specific data between frames, basically.  It mostly stores the node's position.
+    std::string StateCache; // The backend's JSON form of State, built when the backend asks for it.  Empty when stale.
     std::string SavedState; // SavedState is only used in the leftpanel, so we can delete it if you want.
 
+    // Lazy property loading: until first access, the properties only exist as their serialized lines.
+    // Use internal::GetProperties() rather than the Properties member to read them.
+    std::string   PropertySpan;              // Serialized properties, exactly as they were read from the save file.
+    unsigned long PropertySpanEntries = 0;   // Property count of PropertySpan.
+    bool          PropertiesLoaded = true;   // False while PropertySpan holds the properties.
+    bool          PropertySpanBinary = false; // PropertySpan is a binary record (see property_codec.h), not lines.
+    bool          PropertySpanDelta = false;  // PropertySpan only holds what differs from PropertyDefaults.
+
+    // Copy-on-write: the type's defaults, shared by every node of the type.  A node that never diverged from them
+    // has no table of its own: it is "lazily loaded" from an empty delta.
+    std::shared_ptr<const ::Properties> PropertyDefaults;
+
+    // Change tracking (see internal/tracking.h).  Generations come from one per-context counter, so they only grow.
+    unsigned long long PropertyGeneration = 0;   // Generation of the last change to any property (or of the node's creation).
+    unsigned long long PropertyGenerationFloor = 0; // Generation of the last change that wasn't narrowed down to keys.  Every property counts as changed then.
+    std::vector<std::pair<prop_key, unsigned long long>> PropertyGenerations; // Per property: generation of its last change, if newer than the floor.
+    unsigned long long ChangeEpoch = 0;          // Frame in which the node was last queued as changed, so it is queued once per frame.
+
     Node(int id, const char* name, ImColor color = ImColor(255, 255, 255)):
         ID(id), Name(name), Color(color), Type(NodeType::Blueprint), Size(0, 0)
     {
@@ -0,0 +1,281 @@
+#include <internal/async_evaluation.h>
+#include <internal/internal.h>
+
+#include <chrono>
+
+using namespace plano::types;
+namespace ed = ax::NodeEditor;
+
+namespace plano {
+namespace internal {
+
+// The worker's side ==================================================================================================
+
+static void CallSnapshotStep(EvaluationSnapshot& snapshot, uint32_t s, unsigned thread)
+{
+    if (snapshot.Cancelled.load(std::memory_order_relaxed))
+        return;
+    const AsyncStep& step = snapshot.Steps[s];
+    const Value* const* arguments = snapshot.Arguments.data() + step.Inputs;
+    Value* outputs = snapshot.Values.data() + step.Outputs;
+    if (step.MemoKey.empty() || !snapshot.Memo) {
+        step.Evaluate(*step.Properties, arguments, outputs);
+        return;
+    }
+
+    std::string& key = snapshot.Keys[thread];
+    key = step.MemoKey;
+    for (uint32_t i = 0; i < step.InputCount; i++)
+        AppendMemoValue(key, *arguments[i]);
+    uint64_t hash = MemoCache::Hash(key);
+    if (snapshot.Memo->Find(hash, key, outputs, step.OutputCount))
+        return;
+    step.Evaluate(*step.Properties, arguments, outputs);
+    snapshot.Memo->Insert(hash, key, arguments, step.InputCount, outputs, step.OutputCount);
+}
+
+static void RunSnapshotStep(EvaluationSnapshot& snapshot, uint32_t s, unsigned thread)
+{
+    if (snapshot.Timings.empty()) {
+        CallSnapshotStep(snapshot, s, thread);
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    CallSnapshotStep(snapshot, s, thread);
+    snapshot.Timings[s] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// WorkPool task.  Steps of a cancelled snapshot are skipped but still counted down, so the batch ends.
+static void RunParallelSnapshotStep(void* user, uint32_t task, unsigned thread)
+{
+    auto& snapshot = *(EvaluationSnapshot*)user;
+    prop_blob_scope blobs(snapshot.Blobs);
+    const AsyncStep& step = snapshot.Steps[task];
+    RunSnapshotStep(snapshot, task, thread);
+    for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++) {
+        uint32_t next = snapshot.Dependents[d];
+        if (snapshot.Remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            snapshot.Pool->Push(thread, next);
+    }
+}
+
+static void RunSnapshot(EvaluationSnapshot& snapshot, std::unique_ptr<WorkPool>& pool)
+{
+    snapshot.Arguments.resize(snapshot.Sources.size());
+    for (size_t i = 0; i < snapshot.Sources.size(); i++)
+        snapshot.Arguments[i] = &snapshot.Values[snapshot.Sources[i]];
+
+    if (snapshot.Threads <= 1 || snapshot.Steps.size() < 2) {
+        snapshot.Keys.resize(1);
+        for (uint32_t s = 0; s < snapshot.Steps.size(); s++)
+            RunSnapshotStep(snapshot, s, 0);
+        return;
+    }
+
+    if (!pool || pool->Threads() != snapshot.Threads)
+        pool.reset(new WorkPool(snapshot.Threads));
+    snapshot.Pool = pool.get();
+    snapshot.Keys.resize(snapshot.Threads);
+    snapshot.Remaining.reset(new std::atomic<uint32_t>[snapshot.Steps.size()]);
+    for (uint32_t s = 0; s < snapshot.Steps.size(); s++)
+        snapshot.Remaining[s].store(snapshot.Steps[s].Upstream, std::memory_order_relaxed);
+
+    // Pick the first steps before any is queued: once one runs, the counts start moving.
+    std::vector<uint32_t> ready;
+    for (uint32_t s = 0; s < snapshot.Steps.size(); s++)
+        if (snapshot.Steps[s].Upstream == 0)
+            ready.push_back(s);
+    pool->Start(snapshot.Steps.size(), RunParallelSnapshotStep, &snapshot);
+    for (uint32_t s : ready)
+        pool->Push(0, s);
+    pool->Finish();
+    snapshot.Pool = nullptr;
+}
+
+AsyncEvaluator::~AsyncEvaluator()
+{
+    {
+        std::lock_guard<std::mutex> lock(Lock);
+        Quit = true;
+    }
+    Wake.notify_all();
+    if (Thread.joinable())
+        Thread.join();
+}
+
+void AsyncEvaluator::Submit(std::shared_ptr<EvaluationSnapshot> snapshot)
+{
+    {
+        std::lock_guard<std::mutex> lock(Lock);
+        Next = std::move(snapshot);
+        if (!Thread.joinable())
+            Thread = std::thread(&AsyncEvaluator::Loop, this);
+    }
+    Wake.notify_all();
+}
+
+std::shared_ptr<EvaluationSnapshot> AsyncEvaluator::TakeFinished()
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    return std::move(Finished);
+}
+
+void AsyncEvaluator::Wait(const EvaluationSnapshot* snapshot)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+    Done.wait(lock, [&] { return Finished.get() == snapshot; });
+}
+
+void AsyncEvaluator::Loop()
+{
+    std::unique_lock<std::mutex> lock(Lock);
+    for (;;) {
+        Wake.wait(lock, [&] { return Quit || Next; });
+        if (Quit)
+            return;
+        std::shared_ptr<EvaluationSnapshot> snapshot = std::move(Next);
+        lock.unlock();
+        if (!snapshot->Cancelled.load(std::memory_order_relaxed)) {
+            prop_blob_scope blobs(snapshot->Blobs);
+            RunSnapshot(*snapshot, Pool);
+        }
+        lock.lock();
+        if (!snapshot->Cancelled.load(std::memory_order_relaxed)) {
+            Finished = std::move(snapshot);
+            Done.notify_all();
+        }
+    }
+}
+
+// The UI thread's side ===============================================================================================
+
+bool StartAsyncEvaluation()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    AbandonAsyncEvaluation();
+    size_t dirty = CollectDirtySteps();
+    auto& eval = s_Session->Evaluation;
+    auto& nodes = s_Session->s_Nodes;
+    eval.LastRun = dirty;
+    if (dirty == 0)
+        return !eval.Cyclic;
+
+    // Main thread only steps can't go in a snapshot; then the whole run stays here.
+    for (uint32_t s = 0; s < eval.Steps.size(); s++)
+        if (eval.Dirty[s] && eval.Steps[s].MainThreadOnly)
+            return EvaluateGraph();
+
+    auto snapshot = std::make_shared<EvaluationSnapshot>();
+    snapshot->Blobs = &s_Session->Blobs;
+    snapshot->Threads = eval.Threads;
+    snapshot->Memo = eval.Memo.Capacity() ? &eval.Memo : nullptr;
+    snapshot->Timings.assign(s_Session->Profiler.Enabled ? dirty : 0, 0.0);
+
+    // Renumber the dirty steps and the slots they touch.  Every dependent of a dirty step is dirty, so the
+    // snapshot's dependencies stay within it.
+    const uint32_t none = UINT32_MAX;
+    std::vector<uint32_t> local_step(eval.Steps.size(), none);
+    std::vector<uint32_t> local_slot(eval.Values.size(), none);
+    auto take_slot = [&](uint32_t slot) {
+        if (local_slot[slot] == none) {
+            local_slot[slot] = (uint32_t)snapshot->Values.size();
+            snapshot->Values.push_back(eval.Values[slot]);
+            snapshot->SlotPins.push_back(eval.SlotPins[slot]);
+        }
+        return local_slot[slot];
+    };
+    for (uint32_t s = 0; s < eval.Steps.size(); s++)
+        if (eval.Dirty[s]) {
+            local_step[s] = (uint32_t)snapshot->Steps.size();
+            snapshot->Steps.emplace_back();
+        }
+
+    for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+        if (local_step[s] == none)
+            continue;
+        const EvaluationStep& step = eval.Steps[s];
+        const Node& node = nodes[step.Node];
+        AsyncStep& copy = snapshot->Steps[local_step[s]];
+        copy.Evaluate = eval.Tape[s].Evaluate;
+        copy.Properties = SharesDefaultProperties(node) ? node.PropertyDefaults
+                                                        : std::make_shared<const ::Properties>(*eval.Tape[s].Properties);
+        copy.Node = step.Id;
+
+        // Outputs first, so they stay consecutive.
+        copy.Outputs = (uint32_t)snapshot->Values.size();
+        copy.OutputCount = (uint32_t)node.Outputs.size();
+        for (uint32_t o = 0; o < copy.OutputCount; o++)
+            take_slot(step.Outputs + o);
+        copy.Inputs = (uint32_t)snapshot->Sources.size();
+        copy.InputCount = (uint32_t)node.Inputs.size();
+        for (uint32_t i = 0; i < copy.InputCount; i++)
+            snapshot->Sources.push_back(take_slot(eval.Sources[step.Inputs + i]));
+
+        copy.Dependents = (uint32_t)snapshot->Dependents.size();
+        for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++) {
+            uint32_t next = local_step[eval.Dependents[d]];
+            snapshot->Dependents.push_back(next);
+            snapshot->Steps[next].Upstream++;
+        }
+        copy.DependentCount = (uint32_t)snapshot->Dependents.size() - copy.Dependents;
+        if (step.Pure && snapshot->Memo)
+            copy.MemoKey = MemoKeyPrefix(s);
+    }
+
+    MarkStepsEvaluated();
+    s_Session->Async.Current = snapshot;
+    s_Session->Async.Worker.Submit(std::move(snapshot));
+    return !eval.Cyclic;
+}
+
+bool PublishAsyncEvaluation()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& async = s_Session->Async;
+    if (!async.Current)
+        return false;
+    std::shared_ptr<EvaluationSnapshot> finished = async.Worker.TakeFinished();
+    if (finished != async.Current)
+        return false;   // Nothing, or one that was cancelled after it finished.
+    async.Current.reset();
+
+    for (uint32_t s = 0; s < finished->Timings.size(); s++)
+        RecordProfile(finished->Steps[s].Node, finished->Timings[s], finished->Values.data() + finished->Steps[s].Outputs,
+                      finished->Steps[s].OutputCount);
+
+    // Outputs go back by pin id: nodes and links may have changed since.
+    BuildSchedule();
+    auto& eval = s_Session->Evaluation;
+    for (const AsyncStep& step : finished->Steps)
+        for (uint32_t o = 0; o < step.OutputCount; o++) {
+            auto slot = eval.PinSlots.find(finished->SlotPins[step.Outputs + o]);
+            if (slot != eval.PinSlots.end() && slot->second < eval.FirstInputSlot)
+                eval.Values[slot->second] = std::move(finished->Values[step.Outputs + o]);
+        }
+    return true;
+}
+
+void FinishAsyncEvaluation()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& async = s_Session->Async;
+    if (!async.Current)
+        return;
+    async.Worker.Wait(async.Current.get());
+    PublishAsyncEvaluation();
+}
+
+void AbandonAsyncEvaluation()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& async = s_Session->Async;
+    if (!async.Current)
+        return;
+    std::shared_ptr<EvaluationSnapshot> snapshot = std::move(async.Current);
+    snapshot->Cancelled.store(true, std::memory_order_relaxed);
+    for (const AsyncStep& step : snapshot->Steps)
+        MarkNodeDirty(ed::NodeId(step.Node));
+}
+
+} // inner namespace
+} // outer namespace
@@ -1,24 +1,186 @@
 #include <internal/attribute.h>
 #include <plano_api.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 // C to Instance adaptor
-std::string Prop_Serialize(const attr_table& Prop_In, unsigned long& entries)
+std::string Prop_Serialize(const attr_table& Prop_In, unsigned long& entries, const attr_table* Defaults)
 {
-    return Prop_In.serialize(entries);
+    return Prop_In.serialize(entries, Defaults);
 }
 
-void Prop_Deserialize(attr_table& Prop_In, const std::string& serialized_table)
+void Prop_Deserialize(attr_table& Prop_In, const std::string& serialized_table, bool Merge)
 {
-    return Prop_In.deseralize(serialized_table);
+    return Prop_In.deseralize(serialized_table, Merge);
 }
 
+void Prop_SerializeBinary(const attr_table& Prop_In, prop_dictionary& dict, std::string& out, const attr_table* Defaults)
+{
+    Prop_In.encode(out, dict, Defaults);
+}
+
+bool Prop_DeserializeBinary(attr_table& Prop_In, const prop_dictionary& dict, const char* data, size_t size, bool Merge)
+{
+    return Prop_In.decode(data, size, dict, Merge);
+}
+
+void Prop_Diff(const attr_table& Before, const attr_table& After, std::vector<prop_key>& changed)
+{
+    After.diff(Before, changed);
+}
+
+bool Prop_Equal(const attr_table& A, const attr_table& B)
+{
+    return A.equals(B);
+}
+
+bool Prop_Covers(const attr_table& Prop_In, const attr_table& Defaults)
+{
+    return Prop_In.covers(Defaults);
+}
+
+void Prop_Track(attr_table& Prop_In, prop_write_log* Log)
+{
+    Prop_In.track(Log);
+}
+
+void Prop_LoggedChanges(const attr_table& Prop_In, const prop_write_log& Log, std::vector<prop_key>& changed)
+{
+    Prop_In.logged_changes(Log, changed);
+}
 
-std::string attr_table::serialize(unsigned long &entries) const
+// True if "defaults" has the same value for the key.  Properties that are left out of a delta.
+template <typename T>
+static bool IsDefault(const std::map<std::string, T>* defaults, const std::string& key, const T& value)
+{
+    if (!defaults)
+        return false;
+    auto found = defaults->find(key);
+    return found != defaults->end() && found->second == value;
+}
+
+// Both maps are sorted, so one merged walk finds every difference.
+template <typename T>
+static void DiffMaps(const std::map<std::string, T>& before, const std::map<std::string, T>& after, std::vector<prop_key>& changed)
+{
+    auto b = before.begin();
+    auto a = after.begin();
+    while (b != before.end() || a != after.end()) {
+        if (a == after.end() || (b != before.end() && b->first < a->first)) {
+            changed.push_back(prop_intern(b->first));
+            ++b;
+        } else if (b == before.end() || a->first < b->first) {
+            changed.push_back(prop_intern(a->first));
+            ++a;
+        } else {
+            if (!(a->second == b->second))
+                changed.push_back(prop_intern(a->first));
+            ++a;
+            ++b;
+        }
+    }
+}
+
+void attr_table::diff(const attr_table& before, std::vector<prop_key>& changed) const
+{
+    DiffMaps<std::string>(before.pstring, pstring, changed);
+    DiffMaps<int>(before.pint, pint, changed);
+    DiffMaps<float>(before.pfloat, pfloat, changed);
+    DiffMaps<bool>(before.pbool, pbool, changed);
+    DiffMaps<prop_blob>(before.pints, pints, changed);
+    DiffMaps<prop_blob>(before.pfloats, pfloats, changed);
+    DiffMaps<prop_blob>(before.pblob, pblob, changed);
+}
+
+bool attr_table::equals(const attr_table& other) const
+{
+    return pstring == other.pstring && pint == other.pint && pfloat == other.pfloat && pbool == other.pbool
+        && pints == other.pints && pfloats == other.pfloats && pblob == other.pblob;
+}
+
+void attr_table::track(prop_write_log* log)
+{
+    pstring.log = pint.log = pfloat.log = pbool.log = pints.log = pfloats.log = pblob.log = log;
+    pstring.type = prop_type::pstring;
+    pint.type    = prop_type::pint;
+    pfloat.type  = prop_type::pfloat;
+    pbool.type   = prop_type::pbool;
+    pints.type   = prop_type::pints;
+    pfloats.type = prop_type::pfloats;
+    pblob.type   = prop_type::pblob;
+}
+
+template <typename T>
+static const T* FindByName(const std::map<std::string, T>& map, const std::string& name)
+{
+    auto found = map.find(name);
+    return found == map.end() ? nullptr : &found->second;
+}
+
+void attr_table::logged_changes(const prop_write_log& log, std::vector<prop_key>& changed) const
+{
+    for (const prop_write& w : log.writes) {
+        const void* current = nullptr;
+        switch (w.type) {
+            case prop_type::pstring: current = FindByName(pstring, w.name); break;
+            case prop_type::pint:    current = FindByName(pint, w.name);    break;
+            case prop_type::pfloat:  current = FindByName(pfloat, w.name);  break;
+            case prop_type::pbool:   current = FindByName(pbool, w.name);   break;
+            case prop_type::pints:   current = FindByName(pints, w.name);   break;
+            case prop_type::pfloats: current = FindByName(pfloats, w.name); break;
+            case prop_type::pblob:   current = FindByName(pblob, w.name);   break;
+            default: break;
+        }
+        // Only the keys that really changed pay for interning.
+        if (w.changed(current))
+            changed.push_back(prop_intern(w.name));
+    }
+}
+
+template <typename T>
+static bool CoversMap(const std::map<std::string, T>& mine, const std::map<std::string, T>& defaults)
+{
+    for (const auto& kv : defaults)
+        if (mine.find(kv.first) == mine.end())
+            return false;
+    return true;
+}
+
+bool attr_table::covers(const attr_table& defaults) const
+{
+    return CoversMap<std::string>(pstring, defaults.pstring) && CoversMap<int>(pint, defaults.pint)
+        && CoversMap<float>(pfloat, defaults.pfloat) && CoversMap<bool>(pbool, defaults.pbool)
+        && CoversMap<prop_blob>(pints, defaults.pints) && CoversMap<prop_blob>(pfloats, defaults.pfloats)
+        && CoversMap<prop_blob>(pblob, defaults.pblob);
+}
+
+
+// Arrays and blobs: the value line is the byte count, and the raw bytes follow the type line.
+static void SerializeRaw(std::string& out, const std::map<std::string, prop_blob>& map, const std::map<std::string, prop_blob>* defaults,
+                         prop_type type, unsigned long& entries)
+{
+    for (const auto& kv : map) {
+        if (IsDefault(defaults, kv.first, kv.second))
+            continue;
+        out.append(kv.first + "\n");
+        out.append(std::to_string(kv.second.size()) + "\n");
+        out.push_back(prop_text_letter(type));
+        out.push_back('\n');
+        out.append((const char*)kv.second.data(), kv.second.size());
+        out.push_back('\n');
+        entries++;
+    }
+}
+
+std::string attr_table::serialize(unsigned long &entries, const attr_table* defaults) const
 {
     std::string serialization;
     entries =  0;
     
     for(const auto& kv : pstring) {
+        if (IsDefault(defaults ? &defaults->pstring : nullptr, kv.first, kv.second))
+            continue;
         serialization.append(kv.first + "\n"); // write key
         serialization.append(kv.second + "\n"); // write value
         serialization.append("s\n"); // write type flag;
@@ -26,6 +188,8 @@ std::string attr_table::serialize(unsigned long &entries) const
     }
     
     for(const auto& kv : pint) {
+        if (IsDefault(defaults ? &defaults->pint : nullptr, kv.first, kv.second))
+            continue;
         serialization.append(kv.first + "\n"); // write key
         serialization.append(std::to_string(kv.second) + "\n"); // write value
         serialization.append("i\n"); // write type flag;
@@ -33,13 +197,17 @@ std::string attr_table::serialize(unsigned long &entries) const
     }
     
     for(const auto& kv : pfloat) {
+        if (IsDefault(defaults ? &defaults->pfloat : nullptr, kv.first, kv.second))
+            continue;
         serialization.append(kv.first + "\n"); // write key
-        serialization.append(std::to_string(kv.second) + "\n"); // write value
+        serialization.append(prop_format_float(kv.second) + "\n"); // write value, with every digit it needs to read back the same
         serialization.append("f\n"); // write type flag;
         entries++; // track property count
     }
     
     for(const auto& kv : pbool) {
+        if (IsDefault(defaults ? &defaults->pbool : nullptr, kv.first, kv.second))
+            continue;
         serialization.append(kv.first + "\n"); // write key
         if(kv.second) {
             serialization.append("1\n"); // write true
@@ -49,20 +217,132 @@ std::string attr_table::serialize(unsigned long &entries) const
         serialization.append("b\n"); // write type flag;
         entries++; // track property count
     } ///////////////// HEY DO THE DESERIALIZER AND YOU SHOULD BE DONE AND GET BACK TO THE CHECKBOX
+
+    SerializeRaw(serialization, pints, defaults ? &defaults->pints : nullptr, prop_type::pints, entries);
+    SerializeRaw(serialization, pfloats, defaults ? &defaults->pfloats : nullptr, prop_type::pfloats, entries);
+    SerializeRaw(serialization, pblob, defaults ? &defaults->pblob : nullptr, prop_type::pblob, entries);
     
     
     
     return serialization;
 }
 
+void attr_table::encode(std::string& out, prop_dictionary& dict, const attr_table* defaults) const
+{
+    // The count comes first, so a delta is counted before it's written.
+    size_t entries = pstring.size() + pint.size() + pfloat.size() + pbool.size() + pints.size() + pfloats.size() + pblob.size();
+    if (defaults) {
+        for (const auto& kv : pstring) entries -= IsDefault(&defaults->pstring, kv.first, kv.second);
+        for (const auto& kv : pint)    entries -= IsDefault(&defaults->pint, kv.first, kv.second);
+        for (const auto& kv : pfloat)  entries -= IsDefault(&defaults->pfloat, kv.first, kv.second);
+        for (const auto& kv : pbool)   entries -= IsDefault(&defaults->pbool, kv.first, kv.second);
+        for (const auto& kv : pints)   entries -= IsDefault(&defaults->pints, kv.first, kv.second);
+        for (const auto& kv : pfloats) entries -= IsDefault(&defaults->pfloats, kv.first, kv.second);
+        for (const auto& kv : pblob)   entries -= IsDefault(&defaults->pblob, kv.first, kv.second);
+    }
+
+    prop_begin_binary(out, (uint32_t)entries);
+    for (const auto& kv : pstring)
+        if (!IsDefault(defaults ? &defaults->pstring : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pstring, kv.first, &kv.second);
+    for (const auto& kv : pint)
+        if (!IsDefault(defaults ? &defaults->pint : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pint, kv.first, &kv.second);
+    for (const auto& kv : pfloat)
+        if (!IsDefault(defaults ? &defaults->pfloat : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pfloat, kv.first, &kv.second);
+    for (const auto& kv : pbool)
+        if (!IsDefault(defaults ? &defaults->pbool : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pbool, kv.first, &kv.second);
+    for (const auto& kv : pints)
+        if (!IsDefault(defaults ? &defaults->pints : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pints, kv.first, &kv.second);
+    for (const auto& kv : pfloats)
+        if (!IsDefault(defaults ? &defaults->pfloats : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pfloats, kv.first, &kv.second);
+    for (const auto& kv : pblob)
+        if (!IsDefault(defaults ? &defaults->pblob : nullptr, kv.first, kv.second))
+            prop_put_binary(out, dict, prop_type::pblob, kv.first, &kv.second);
+}
+
+bool attr_table::decode(const char* data, size_t size, const prop_dictionary& dict, bool merge)
+{
+    if (!merge)
+        clear();
+    prop_binary_reader in(data, size, dict);
+    uint32_t entries;
+    if (!in.begin(entries))
+        return false;
+
+    for (uint32_t i = 0; i < entries; i++) {
+        prop_type type;
+        const prop_key* key;
+        if (!in.next(type, key))
+            return false;
+
+        bool ok = false;
+        switch (type) {
+            case prop_type::pint:   ok = in.get(pint[*key]);   break;
+            case prop_type::pfloat: ok = in.get(pfloat[*key]); break;
+            case prop_type::pbool:  ok = in.get(pbool[*key]);  break;
+            case prop_type::pstring: {
+                const char* text;
+                size_t length;
+                ok = in.get(text, length);
+                if (ok)
+                    pstring[*key].assign(text, length);
+                break;
+            }
+            case prop_type::pints:
+            case prop_type::pfloats:
+            case prop_type::pblob: {
+                const char* bytes;
+                size_t length;
+                ok = in.get(bytes, length);
+                if (ok)
+                    (type == prop_type::pints ? pints : type == prop_type::pfloats ? pfloats : pblob)[*key] = prop_blob::from_bytes(bytes, length);
+                break;
+            }
+            default: break;
+        }
+        if (!ok)
+            return false;
+    }
+    return in.done();
+}
+
 void attr_table::clear(void) {
     pstring.clear();
     pint.clear();
     pfloat.clear();
+    pbool.clear();
+    pints.clear();
+    pfloats.clear();
+    pblob.clear();
+
+    if (!schema)
+        return;
+    size_t string_index = 0;
+    for (const auto& field : schema->fields) {
+        const unsigned char* value = schema->prototype.data() + field.offset;
+        switch (field.type) {
+            case prop_type::pstring: pstring[field.key] = schema->strings[string_index++]; break;
+            case prop_type::pint:    memcpy(&pint[field.key], value, sizeof(int));        break;
+            case prop_type::pfloat:  memcpy(&pfloat[field.key], value, sizeof(float));    break;
+            case prop_type::pbool:   memcpy(&pbool[field.key], value, sizeof(bool));      break;
+            default: break;
+        }
+    }
+}
+
+void attr_table::set_schema(std::shared_ptr<const prop_schema> layout) {
+    schema = std::move(layout);
+    clear();
 }
 
-void attr_table::deseralize(const std::string& serialized_table) {
-    clear(); // attr_table::clear();
+void attr_table::deseralize(const std::string& serialized_table, bool merge) {
+    if (!merge)
+        clear(); // attr_table::clear();
     if(serialized_table.size() == 0)
         return;
 
@@ -71,15 +351,31 @@ void attr_table::deseralize(const std::string& serialized_table) {
 
 
 
+    // strtof/strtol rather than stof/stoi: a damaged file reads as zeroes instead of throwing.
     for(int line_num = 0; std::getline(iss,line1); line_num +=3) {
         std::getline(iss,line2);
         std::getline(iss,line3);
+        if (line3.empty())
+            continue;
         switch (line3.at(0)) {
-            case 's' : pstring[line1] = line2;            break;
-            case 'f' : pfloat[line1]  = std::stof(line2); break;
-            case 'i' : pint[line1]    = std::stoi(line2); break;
-            case 'b' : pbool[line1]   = std::stoi(line2) == 1 ? true : false;
-                        
+            case 's' : pstring[line1] = line2;                                   break;
+            case 'f' : pfloat[line1]  = std::strtof(line2.c_str(), nullptr);      break;
+            case 'i' : pint[line1]    = (int)std::strtol(line2.c_str(), nullptr, 10); break;
+            case 'b' : pbool[line1]   = std::strtol(line2.c_str(), nullptr, 10) == 1 ? true : false; break;
+            case 'I' :
+            case 'F' :
+            case 'x' : {
+                // Raw bytes follow the type line.  A damaged count takes what's left of the record.
+                std::streamoff offset = iss.tellg();
+                size_t at = offset < 0 ? serialized_table.size() : (size_t)offset;
+                size_t length = std::min((size_t)std::strtoul(line2.c_str(), nullptr, 10), serialized_table.size() - at);
+                auto& blobs = line3[0] == 'I' ? pints : line3[0] == 'F' ? pfloats : pblob;
+                blobs[line1] = prop_blob::from_bytes(serialized_table.data() + at, length);
+                iss.seekg((std::streamoff)(at + length));
+                if (iss.peek() == '\n')
+                    iss.get();
+                break;
+            }
         }
     }
 }
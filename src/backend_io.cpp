@@ -0,0 +1,83 @@
+#include <internal/internal.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace plano::types;
+
+namespace plano {
+namespace internal {
+
+// The backend writes its node settings like this (group_size only for groups):
+//   {"location":{"x":-10,"y":20},"group_size":{"x":300,"y":200}}
+// This is not a JSON parser.  It only looks for the members the backend is known to write.
+
+// Finds "key": {"x": ..., "y": ...} in json and reads it into v.
+static bool ParseVec2Member(const std::string& json, const char* key, ImVec2& v)
+{
+    std::string quoted = std::string("\"") + key + "\"";
+    size_t at = json.find(quoted);
+    if (at == std::string::npos)
+        return false;
+
+    size_t open = json.find('{', at + quoted.size());
+    size_t close = json.find('}', open);
+    if (open == std::string::npos || close == std::string::npos)
+        return false;
+
+    size_t x = json.find("\"x\"", open);
+    size_t y = json.find("\"y\"", open);
+    if (x > close || y > close)
+        return false;
+
+    size_t x_colon = json.find(':', x);
+    size_t y_colon = json.find(':', y);
+    if (x_colon > close || y_colon > close)
+        return false;
+
+    v.x = std::strtof(json.c_str() + x_colon + 1, nullptr);
+    v.y = std::strtof(json.c_str() + y_colon + 1, nullptr);
+    return true;
+}
+
+bool ParseNodeState(const char* data, size_t size, NodeState& state)
+{
+    std::string json(data, size);
+
+    NodeState parsed;
+    parsed.HasLocation  = ParseVec2Member(json, "location", parsed.Location);
+    parsed.HasSize      = ParseVec2Member(json, "size", parsed.Size);
+    parsed.HasGroupSize = ParseVec2Member(json, "group_size", parsed.GroupSize);
+    if (!parsed.HasLocation)
+        return false;
+
+    state = parsed;
+    return true;
+}
+
+static void AppendVec2Member(std::string& json, const char* key, const ImVec2& v)
+{
+    // %.9g is enough digits for a float to come back bit exact.
+    char buf[96];
+    snprintf(buf, sizeof(buf), "\"%s\":{\"x\":%.9g,\"y\":%.9g}", key, v.x, v.y);
+    if (json.size() > 1)
+        json.push_back(',');
+    json.append(buf);
+}
+
+std::string FormatNodeState(const NodeState& state)
+{
+    std::string json = "{";
+    if (state.HasLocation)
+        AppendVec2Member(json, "location", state.Location);
+    if (state.HasSize)
+        AppendVec2Member(json, "size", state.Size);
+    if (state.HasGroupSize)
+        AppendVec2Member(json, "group_size", state.GroupSize);
+    json.push_back('}');
+    return json;
+}
+
+} // inner namespace
+} // outer namespace
@@ -0,0 +1,204 @@
+#include <internal/batch_evaluation.h>
+#include <internal/internal.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace plano::types;
+namespace ed = ax::NodeEditor;
+
+namespace plano {
+namespace internal {
+
+// Bytes per record of a column, 0 for pins that don't get one.
+static size_t ElementSize(PinType type)
+{
+    switch (type) {
+        case PinType::Bool:  return sizeof(bool);
+        case PinType::Int:   return sizeof(int);
+        case PinType::Float: return sizeof(float);
+        default:             return 0;
+    }
+}
+
+static uint8_t* ArenaBase(BatchState& batch)
+{
+    uintptr_t address = (uintptr_t)batch.Arena.data();
+    return batch.Arena.data() + ((32 - (address & 31)) & 31);
+}
+
+static void LayOut(BatchState& batch, const EvaluationState& eval, size_t count)
+{
+    size_t slots = eval.Values.size();
+    batch.Types.resize(slots);
+    batch.Columns.assign(slots, SIZE_MAX);
+    batch.Written.assign(slots, 0);
+
+    size_t offset = 0;
+    for (size_t slot = 0; slot < slots; slot++) {
+        const Pin* pin = FindPin(ed::PinId(eval.SlotPins[slot]));
+        batch.Types[slot] = pin ? pin->Type : eval.Values[slot].Type;
+        size_t size = ElementSize(batch.Types[slot]);
+        if (size == 0)
+            continue;
+        batch.Columns[slot] = offset;
+        offset += (count * size + 31) & ~(size_t)31;
+    }
+
+    auto& nodes = s_Session->s_Nodes;
+    for (auto& step : eval.Steps)
+        for (size_t o = 0; o < nodes[step.Node].Outputs.size(); o++)
+            batch.Written[step.Outputs + o] = 1;
+
+    batch.Arena.resize(offset + 32);   // Room to align the start.
+    batch.Count = count;
+    batch.Built = eval.Built;
+}
+
+static void Repeat(void* column, PinType type, const Value& value, size_t count)
+{
+    switch (type) {
+        case PinType::Bool:  std::memset(column, value.Bool ? 1 : 0, count); break;
+        case PinType::Int:   std::fill_n((int*)column, count, value.Int); break;
+        case PinType::Float: std::fill_n((float*)column, count, value.Float); break;
+        default: break;
+    }
+}
+
+static ValueSpan Span(BatchState& batch, EvaluationState& eval, uint8_t* base, uint32_t slot)
+{
+    ValueSpan span;
+    span.Type = batch.Types[slot];
+    span.Count = batch.Count;
+    if (batch.Columns[slot] != SIZE_MAX)
+        span.Data = base + batch.Columns[slot];
+    else
+        span.Uniform = &eval.Values[slot];
+    return span;
+}
+
+// For node types without EvaluateBatch: Evaluate, record by record.  Single values are copied once; only the
+// column values change between calls.
+static void RunPerRecord(BatchState& batch, EvaluationState& eval, uint32_t s, const ::Properties& properties, uint8_t* base)
+{
+    const EvaluationStep& step = eval.Steps[s];
+    const Node& node = s_Session->s_Nodes[step.Node];
+    size_t inputs = node.Inputs.size(), outputs = node.Outputs.size();
+    batch.Scalars.resize(inputs + outputs);
+    batch.Pointers.resize(inputs);
+    for (size_t i = 0; i < inputs; i++) {
+        batch.Scalars[i] = eval.Values[eval.Sources[step.Inputs + i]];
+        batch.Pointers[i] = &batch.Scalars[i];
+    }
+
+    for (size_t r = 0; r < batch.Count; r++) {
+        for (size_t i = 0; i < inputs; i++) {
+            uint32_t slot = eval.Sources[step.Inputs + i];
+            if (batch.Columns[slot] == SIZE_MAX)
+                continue;
+            const uint8_t* column = base + batch.Columns[slot];
+            switch (batch.Types[slot]) {
+                case PinType::Bool:  batch.Scalars[i].Bool = ((const bool*)column)[r]; break;
+                case PinType::Int:   batch.Scalars[i].Int = ((const int*)column)[r]; break;
+                case PinType::Float: batch.Scalars[i].Float = ((const float*)column)[r]; break;
+                default: break;
+            }
+        }
+        for (size_t o = 0; o < outputs; o++)
+            batch.Scalars[inputs + o] = Value(batch.Types[step.Outputs + o]);
+
+        eval.Tape[s].Evaluate(properties, batch.Pointers.data(), batch.Scalars.data() + inputs);
+
+        for (size_t o = 0; o < outputs; o++) {
+            uint32_t slot = step.Outputs + (uint32_t)o;
+            if (batch.Columns[slot] == SIZE_MAX)
+                continue;
+            uint8_t* column = base + batch.Columns[slot];
+            const Value& value = batch.Scalars[inputs + o];
+            switch (batch.Types[slot]) {
+                case PinType::Bool:  ((bool*)column)[r] = value.Bool; break;
+                case PinType::Int:   ((int*)column)[r] = value.Int; break;
+                case PinType::Float: ((float*)column)[r] = value.Float; break;
+                default: break;
+            }
+        }
+    }
+}
+
+bool EvaluateGraphBatch(size_t count)
+{
+    BuildSchedule();
+    auto& eval = s_Session->Evaluation;
+    auto& batch = s_Session->Batch;
+    auto& nodes = s_Session->s_Nodes;
+
+    if (batch.Built != eval.Built || batch.Count != count || batch.Columns.size() != eval.Values.size())
+        LayOut(batch, eval, count);
+    uint8_t* base = ArenaBase(batch);
+
+    // Every column no step writes gets its values up front.
+    for (uint32_t slot = 0; slot < eval.Values.size(); slot++) {
+        if (batch.Columns[slot] == SIZE_MAX || batch.Written[slot])
+            continue;
+        uint8_t* column = base + batch.Columns[slot];
+        if (slot >= eval.FirstInputSlot) {
+            auto given = batch.Inputs.find(eval.SlotPins[slot]);
+            if (given != batch.Inputs.end()) {
+                if (given->second.Count < count)
+                    return false;
+                std::memcpy(column, given->second.Bytes.data(), count * ElementSize(batch.Types[slot]));
+                continue;
+            }
+        }
+        Repeat(column, batch.Types[slot], eval.Values[slot], count);
+    }
+
+    for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+        const EvaluationStep& step = eval.Steps[s];
+        const Node& node = nodes[step.Node];
+        const ::Properties& properties = PeekProperties(nodes[step.Node]);
+        if (!step.EvaluateBatch) {
+            RunPerRecord(batch, eval, s, properties, base);
+            continue;
+        }
+
+        batch.Spans.clear();
+        for (size_t i = 0; i < node.Inputs.size(); i++)
+            batch.Spans.push_back(Span(batch, eval, base, eval.Sources[step.Inputs + i]));
+        for (size_t o = 0; o < node.Outputs.size(); o++)
+            batch.Spans.push_back(Span(batch, eval, base, step.Outputs + (uint32_t)o));
+        step.EvaluateBatch(properties, batch.Spans.data(), batch.Spans.data() + node.Inputs.size());
+    }
+    return !eval.Cyclic;
+}
+
+bool SetBatchInput(ed::PinId id, PinType type, const void* values, size_t count)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    const PinSlot* slot = FindPinSlot(id);
+    if (!slot || slot->Output || s_Session->s_Nodes[slot->Node].Inputs[slot->Pin].Type != type || !ElementSize(type))
+        return false;
+
+    BatchInput& input = s_Session->Batch.Inputs[id.Get()];
+    input.Type = type;
+    input.Count = count;
+    input.Bytes.assign((const uint8_t*)values, (const uint8_t*)values + count * ElementSize(type));
+    return true;
+}
+
+const void* BatchColumn(ed::PinId id, PinType type)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& eval = s_Session->Evaluation;
+    auto& batch = s_Session->Batch;
+    if (batch.Built != eval.Built || eval.Built != eval.Structure)
+        return nullptr;
+
+    auto slot = eval.PinSlots.find(id.Get());
+    if (slot == eval.PinSlots.end() || batch.Types[slot->second] != type || batch.Columns[slot->second] == SIZE_MAX)
+        return nullptr;
+    return ArenaBase(batch) + batch.Columns[slot->second];
+}
+
+} // inner namespace
+} // outer namespace
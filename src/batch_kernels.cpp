@@ -0,0 +1,360 @@
+#include <internal/batch_kernels.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define PLANO_BATCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PLANO_TARGET_SSE2
+#define PLANO_TARGET_AVX2
+#else
+#define PLANO_TARGET_SSE2 __attribute__((target("sse2")))
+#define PLANO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static_assert(sizeof(bool) == 1, "batch kernels treat bools as bytes");
+
+namespace plano {
+namespace internal {
+
+// The scalar definition of every operation.  The SIMD kernels use them for their tails, and match them otherwise.
+struct AddOp      { static float Apply(float a, float b) { return a + b; } static int Apply(int a, int b) { return (int)((unsigned)a + (unsigned)b); } };
+struct SubtractOp { static float Apply(float a, float b) { return a - b; } static int Apply(int a, int b) { return (int)((unsigned)a - (unsigned)b); } };
+struct MultiplyOp { static float Apply(float a, float b) { return a * b; } static int Apply(int a, int b) { return (int)((unsigned)a * (unsigned)b); } };
+struct DivideOp   { static float Apply(float a, float b) { return a / b; } static int Apply(int a, int b) { return b == 0 ? 0 : (b == -1 ? (int)(0u - (unsigned)a) : a / b); } };
+struct MinOp      { template <typename T> static T Apply(T a, T b) { return a < b ? a : b; } };
+struct MaxOp      { template <typename T> static T Apply(T a, T b) { return a > b ? a : b; } };
+struct LessOp     { template <typename T> static bool Apply(T a, T b) { return a < b; } };
+struct GreaterOp  { template <typename T> static bool Apply(T a, T b) { return a > b; } };
+struct EqualOp    { template <typename T> static bool Apply(T a, T b) { return a == b; } };
+
+template <typename Op, typename T>
+static void ScalarMath(const T* a, const T* b, T* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = Op::Apply(a[i], b[i]);
+}
+
+template <typename Op, typename T>
+static void ScalarCompare(const T* a, const T* b, bool* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = Op::Apply(a[i], b[i]);
+}
+
+template <typename T>
+static void ScalarSelect(const bool* c, const T* a, const T* b, T* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = c[i] ? a[i] : b[i];
+}
+
+static void ScalarAnd(const bool* a, const bool* b, bool* out, size_t n) { for (size_t i = 0; i < n; i++) out[i] = a[i] && b[i]; }
+static void ScalarOr(const bool* a, const bool* b, bool* out, size_t n)  { for (size_t i = 0; i < n; i++) out[i] = a[i] || b[i]; }
+static void ScalarNot(const bool* a, bool* out, size_t n)                { for (size_t i = 0; i < n; i++) out[i] = !a[i]; }
+
+static const BatchKernels s_Scalar = {
+    "scalar",
+    { ScalarMath<AddOp, float>, ScalarMath<SubtractOp, float>, ScalarMath<MultiplyOp, float>, ScalarMath<DivideOp, float>,
+      ScalarMath<MinOp, float>, ScalarMath<MaxOp, float> },
+    { ScalarMath<AddOp, int>, ScalarMath<SubtractOp, int>, ScalarMath<MultiplyOp, int>, ScalarMath<DivideOp, int>,
+      ScalarMath<MinOp, int>, ScalarMath<MaxOp, int> },
+    { ScalarCompare<LessOp, float>, ScalarCompare<GreaterOp, float>, ScalarCompare<EqualOp, float> },
+    { ScalarCompare<LessOp, int>, ScalarCompare<GreaterOp, int>, ScalarCompare<EqualOp, int> },
+    ScalarSelect<float>, ScalarSelect<int>,
+    ScalarAnd, ScalarOr, ScalarNot,
+};
+
+#ifdef PLANO_BATCH_X86
+
+// Compare masks come out as bits (movemask); this turns 8 of them into 8 bools in one store.
+struct ExpandBits {
+    uint64_t Bytes[256];
+    ExpandBits() {
+        for (unsigned m = 0; m < 256; m++) {
+            Bytes[m] = 0;
+            for (unsigned j = 0; j < 8; j++)
+                if (m & (1u << j))
+                    Bytes[m] |= 1ull << (8 * j);   // x86 is little endian: byte j is bool j.
+        }
+    }
+};
+static const ExpandBits s_Expand;
+
+// Kernels are stamped out by these.  In "Expr", va and vb are the loaded vectors.
+#define PLANO_SSE2_MATH(Name, Op, T, Vec, Load, Store, Expr)                                 \
+    PLANO_TARGET_SSE2 static void Name(const T* a, const T* b, T* out, size_t n) {          \
+        size_t i = 0;                                                                        \
+        for (; i + 4 <= n; i += 4) {                                                         \
+            Vec va = Load(a + i), vb = Load(b + i);                                          \
+            Store(out + i, Expr);                                                            \
+        }                                                                                    \
+        for (; i < n; i++)                                                                   \
+            out[i] = Op::Apply(a[i], b[i]);                                                  \
+    }
+
+#define PLANO_AVX2_MATH(Name, Op, T, Vec, Load, Store, Expr)                                 \
+    PLANO_TARGET_AVX2 static void Name(const T* a, const T* b, T* out, size_t n) {          \
+        size_t i = 0;                                                                        \
+        for (; i + 8 <= n; i += 8) {                                                         \
+            Vec va = Load(a + i), vb = Load(b + i);                                          \
+            Store(out + i, Expr);                                                            \
+        }                                                                                    \
+        for (; i < n; i++)                                                                   \
+            out[i] = Op::Apply(a[i], b[i]);                                                  \
+    }
+
+// SSE2 compares 8 values as two halves; Mask turns a compare result into 4 bits.
+#define PLANO_SSE2_COMPARE(Name, Op, T, Vec, Load, Mask, Expr)                               \
+    PLANO_TARGET_SSE2 static void Name(const T* a, const T* b, bool* out, size_t n) {       \
+        size_t i = 0;                                                                        \
+        for (; i + 8 <= n; i += 8) {                                                         \
+            Vec va = Load(a + i), vb = Load(b + i);                                          \
+            int bits = Mask(Expr);                                                           \
+            va = Load(a + i + 4); vb = Load(b + i + 4);                                      \
+            bits |= Mask(Expr) << 4;                                                         \
+            std::memcpy(out + i, &s_Expand.Bytes[bits], 8);                                  \
+        }                                                                                    \
+        for (; i < n; i++)                                                                   \
+            out[i] = Op::Apply(a[i], b[i]);                                                  \
+    }
+
+#define PLANO_AVX2_COMPARE(Name, Op, T, Vec, Load, Mask, Expr)                               \
+    PLANO_TARGET_AVX2 static void Name(const T* a, const T* b, bool* out, size_t n) {       \
+        size_t i = 0;                                                                        \
+        for (; i + 8 <= n; i += 8) {                                                         \
+            Vec va = Load(a + i), vb = Load(b + i);                                          \
+            std::memcpy(out + i, &s_Expand.Bytes[Mask(Expr)], 8);                            \
+        }                                                                                    \
+        for (; i < n; i++)                                                                   \
+            out[i] = Op::Apply(a[i], b[i]);                                                  \
+    }
+
+#define PLANO_LOAD_PS(p)      _mm_loadu_ps(p)
+#define PLANO_LOAD_EPI32(p)   _mm_loadu_si128((const __m128i*)(p))
+#define PLANO_STORE_EPI32(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#define PLANO_MASK_PS(v)      _mm_movemask_ps(v)
+#define PLANO_MASK_EPI32(v)   _mm_movemask_ps(_mm_castsi128_ps(v))
+#define PLANO_LOAD256_EPI32(p)  _mm256_loadu_si256((const __m256i*)(p))
+#define PLANO_STORE256_EPI32(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#define PLANO_MASK256_PS(v)     _mm256_movemask_ps(v)
+#define PLANO_MASK256_EPI32(v)  _mm256_movemask_ps(_mm256_castsi256_ps(v))
+
+// SSE2 has no 32 bit integer min/max (that's SSE4.1): compare and blend.
+PLANO_TARGET_SSE2 static inline __m128i Sse2Blend(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+PLANO_SSE2_MATH(Sse2AddF, AddOp,      float, __m128, PLANO_LOAD_PS, _mm_storeu_ps, _mm_add_ps(va, vb))
+PLANO_SSE2_MATH(Sse2SubF, SubtractOp, float, __m128, PLANO_LOAD_PS, _mm_storeu_ps, _mm_sub_ps(va, vb))
+PLANO_SSE2_MATH(Sse2MulF, MultiplyOp, float, __m128, PLANO_LOAD_PS, _mm_storeu_ps, _mm_mul_ps(va, vb))
+PLANO_SSE2_MATH(Sse2DivF, DivideOp,   float, __m128, PLANO_LOAD_PS, _mm_storeu_ps, _mm_div_ps(va, vb))
+PLANO_SSE2_MATH(Sse2MinF, MinOp,      float, __m128, PLANO_LOAD_PS, _mm_storeu_ps, _mm_min_ps(va, vb))
+PLANO_SSE2_MATH(Sse2MaxF, MaxOp,      float, __m128, PLANO_LOAD_PS, _mm_storeu_ps, _mm_max_ps(va, vb))
+PLANO_SSE2_MATH(Sse2AddI, AddOp,      int, __m128i, PLANO_LOAD_EPI32, PLANO_STORE_EPI32, _mm_add_epi32(va, vb))
+PLANO_SSE2_MATH(Sse2SubI, SubtractOp, int, __m128i, PLANO_LOAD_EPI32, PLANO_STORE_EPI32, _mm_sub_epi32(va, vb))
+PLANO_SSE2_MATH(Sse2MinI, MinOp,      int, __m128i, PLANO_LOAD_EPI32, PLANO_STORE_EPI32, Sse2Blend(_mm_cmplt_epi32(va, vb), va, vb))
+PLANO_SSE2_MATH(Sse2MaxI, MaxOp,      int, __m128i, PLANO_LOAD_EPI32, PLANO_STORE_EPI32, Sse2Blend(_mm_cmpgt_epi32(va, vb), va, vb))
+
+PLANO_SSE2_COMPARE(Sse2LessF,    LessOp,    float, __m128, PLANO_LOAD_PS, PLANO_MASK_PS, _mm_cmplt_ps(va, vb))
+PLANO_SSE2_COMPARE(Sse2GreaterF, GreaterOp, float, __m128, PLANO_LOAD_PS, PLANO_MASK_PS, _mm_cmpgt_ps(va, vb))
+PLANO_SSE2_COMPARE(Sse2EqualF,   EqualOp,   float, __m128, PLANO_LOAD_PS, PLANO_MASK_PS, _mm_cmpeq_ps(va, vb))
+PLANO_SSE2_COMPARE(Sse2LessI,    LessOp,    int, __m128i, PLANO_LOAD_EPI32, PLANO_MASK_EPI32, _mm_cmplt_epi32(va, vb))
+PLANO_SSE2_COMPARE(Sse2GreaterI, GreaterOp, int, __m128i, PLANO_LOAD_EPI32, PLANO_MASK_EPI32, _mm_cmpgt_epi32(va, vb))
+PLANO_SSE2_COMPARE(Sse2EqualI,   EqualOp,   int, __m128i, PLANO_LOAD_EPI32, PLANO_MASK_EPI32, _mm_cmpeq_epi32(va, vb))
+
+// 4 bools -> 4 lane masks.
+PLANO_TARGET_SSE2 static inline __m128i Sse2BoolMask(const bool* c)
+{
+    int bytes;
+    std::memcpy(&bytes, c, 4);
+    __m128i zero = _mm_setzero_si128();
+    __m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+    return _mm_cmpgt_epi32(lanes, zero);
+}
+
+PLANO_TARGET_SSE2 static void Sse2SelectF(const bool* c, const float* a, const float* b, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 mask = _mm_castsi128_ps(Sse2BoolMask(c + i));
+        _mm_storeu_ps(out + i, _mm_or_ps(_mm_and_ps(mask, _mm_loadu_ps(a + i)), _mm_andnot_ps(mask, _mm_loadu_ps(b + i))));
+    }
+    ScalarSelect(c + i, a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_SSE2 static void Sse2SelectI(const bool* c, const int* a, const int* b, int* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        PLANO_STORE_EPI32(out + i, Sse2Blend(Sse2BoolMask(c + i), PLANO_LOAD_EPI32(a + i), PLANO_LOAD_EPI32(b + i)));
+    ScalarSelect(c + i, a + i, b + i, out + i, n - i);
+}
+
+// Bools are 0 or 1, so bytewise and/or keep them so, and not is xor 1.
+PLANO_TARGET_SSE2 static void Sse2And(const bool* a, const bool* b, bool* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        PLANO_STORE_EPI32(out + i, _mm_and_si128(PLANO_LOAD_EPI32(a + i), PLANO_LOAD_EPI32(b + i)));
+    ScalarAnd(a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_SSE2 static void Sse2Or(const bool* a, const bool* b, bool* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        PLANO_STORE_EPI32(out + i, _mm_or_si128(PLANO_LOAD_EPI32(a + i), PLANO_LOAD_EPI32(b + i)));
+    ScalarOr(a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_SSE2 static void Sse2Not(const bool* a, bool* out, size_t n)
+{
+    size_t i = 0;
+    __m128i one = _mm_set1_epi8(1);
+    for (; i + 16 <= n; i += 16)
+        PLANO_STORE_EPI32(out + i, _mm_xor_si128(PLANO_LOAD_EPI32(a + i), one));
+    ScalarNot(a + i, out + i, n - i);
+}
+
+static const BatchKernels s_Sse2 = {
+    "sse2",
+    { Sse2AddF, Sse2SubF, Sse2MulF, Sse2DivF, Sse2MinF, Sse2MaxF },
+    { Sse2AddI, Sse2SubI, ScalarMath<MultiplyOp, int>, ScalarMath<DivideOp, int>, Sse2MinI, Sse2MaxI },
+    { Sse2LessF, Sse2GreaterF, Sse2EqualF },
+    { Sse2LessI, Sse2GreaterI, Sse2EqualI },
+    Sse2SelectF, Sse2SelectI,
+    Sse2And, Sse2Or, Sse2Not,
+};
+
+PLANO_AVX2_MATH(Avx2AddF, AddOp,      float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps(va, vb))
+PLANO_AVX2_MATH(Avx2SubF, SubtractOp, float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps(va, vb))
+PLANO_AVX2_MATH(Avx2MulF, MultiplyOp, float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps(va, vb))
+PLANO_AVX2_MATH(Avx2DivF, DivideOp,   float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_div_ps(va, vb))
+PLANO_AVX2_MATH(Avx2MinF, MinOp,      float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps(va, vb))
+PLANO_AVX2_MATH(Avx2MaxF, MaxOp,      float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps(va, vb))
+PLANO_AVX2_MATH(Avx2AddI, AddOp,      int, __m256i, PLANO_LOAD256_EPI32, PLANO_STORE256_EPI32, _mm256_add_epi32(va, vb))
+PLANO_AVX2_MATH(Avx2SubI, SubtractOp, int, __m256i, PLANO_LOAD256_EPI32, PLANO_STORE256_EPI32, _mm256_sub_epi32(va, vb))
+PLANO_AVX2_MATH(Avx2MulI, MultiplyOp, int, __m256i, PLANO_LOAD256_EPI32, PLANO_STORE256_EPI32, _mm256_mullo_epi32(va, vb))
+PLANO_AVX2_MATH(Avx2MinI, MinOp,      int, __m256i, PLANO_LOAD256_EPI32, PLANO_STORE256_EPI32, _mm256_min_epi32(va, vb))
+PLANO_AVX2_MATH(Avx2MaxI, MaxOp,      int, __m256i, PLANO_LOAD256_EPI32, PLANO_STORE256_EPI32, _mm256_max_epi32(va, vb))
+
+PLANO_AVX2_COMPARE(Avx2LessF,    LessOp,    float, __m256, _mm256_loadu_ps, PLANO_MASK256_PS, _mm256_cmp_ps(va, vb, _CMP_LT_OQ))
+PLANO_AVX2_COMPARE(Avx2GreaterF, GreaterOp, float, __m256, _mm256_loadu_ps, PLANO_MASK256_PS, _mm256_cmp_ps(va, vb, _CMP_GT_OQ))
+PLANO_AVX2_COMPARE(Avx2EqualF,   EqualOp,   float, __m256, _mm256_loadu_ps, PLANO_MASK256_PS, _mm256_cmp_ps(va, vb, _CMP_EQ_OQ))
+PLANO_AVX2_COMPARE(Avx2LessI,    LessOp,    int, __m256i, PLANO_LOAD256_EPI32, PLANO_MASK256_EPI32, _mm256_cmpgt_epi32(vb, va))
+PLANO_AVX2_COMPARE(Avx2GreaterI, GreaterOp, int, __m256i, PLANO_LOAD256_EPI32, PLANO_MASK256_EPI32, _mm256_cmpgt_epi32(va, vb))
+PLANO_AVX2_COMPARE(Avx2EqualI,   EqualOp,   int, __m256i, PLANO_LOAD256_EPI32, PLANO_MASK256_EPI32, _mm256_cmpeq_epi32(va, vb))
+
+// 8 bools -> 8 lane masks.
+PLANO_TARGET_AVX2 static inline __m256i Avx2BoolMask(const bool* c)
+{
+    __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)c));
+    return _mm256_cmpgt_epi32(lanes, _mm256_setzero_si256());
+}
+
+PLANO_TARGET_AVX2 static void Avx2SelectF(const bool* c, const float* a, const float* b, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_blendv_ps(_mm256_loadu_ps(b + i), _mm256_loadu_ps(a + i),
+                                                   _mm256_castsi256_ps(Avx2BoolMask(c + i))));
+    ScalarSelect(c + i, a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_AVX2 static void Avx2SelectI(const bool* c, const int* a, const int* b, int* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        PLANO_STORE256_EPI32(out + i, _mm256_blendv_epi8(PLANO_LOAD256_EPI32(b + i), PLANO_LOAD256_EPI32(a + i),
+                                                         Avx2BoolMask(c + i)));
+    ScalarSelect(c + i, a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_AVX2 static void Avx2And(const bool* a, const bool* b, bool* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+        PLANO_STORE256_EPI32(out + i, _mm256_and_si256(PLANO_LOAD256_EPI32(a + i), PLANO_LOAD256_EPI32(b + i)));
+    ScalarAnd(a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_AVX2 static void Avx2Or(const bool* a, const bool* b, bool* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+        PLANO_STORE256_EPI32(out + i, _mm256_or_si256(PLANO_LOAD256_EPI32(a + i), PLANO_LOAD256_EPI32(b + i)));
+    ScalarOr(a + i, b + i, out + i, n - i);
+}
+
+PLANO_TARGET_AVX2 static void Avx2Not(const bool* a, bool* out, size_t n)
+{
+    size_t i = 0;
+    __m256i one = _mm256_set1_epi8(1);
+    for (; i + 32 <= n; i += 32)
+        PLANO_STORE256_EPI32(out + i, _mm256_xor_si256(PLANO_LOAD256_EPI32(a + i), one));
+    ScalarNot(a + i, out + i, n - i);
+}
+
+static const BatchKernels s_Avx2 = {
+    "avx2",
+    { Avx2AddF, Avx2SubF, Avx2MulF, Avx2DivF, Avx2MinF, Avx2MaxF },
+    { Avx2AddI, Avx2SubI, Avx2MulI, ScalarMath<DivideOp, int>, Avx2MinI, Avx2MaxI },
+    { Avx2LessF, Avx2GreaterF, Avx2EqualF },
+    { Avx2LessI, Avx2GreaterI, Avx2EqualI },
+    Avx2SelectF, Avx2SelectI,
+    Avx2And, Avx2Or, Avx2Not,
+};
+
+#endif // PLANO_BATCH_X86
+
+BatchLevel DetectBatchLevel()
+{
+#if defined(PLANO_BATCH_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int leaves = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6; // And the OS saves ymm.
+    bool avx2 = false;
+    if (avx && leaves >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? BatchLevel::AVX2 : sse2 ? BatchLevel::SSE2 : BatchLevel::Scalar;
+#elif defined(PLANO_BATCH_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? BatchLevel::AVX2
+         : __builtin_cpu_supports("sse2") ? BatchLevel::SSE2 : BatchLevel::Scalar;
+#else
+    return BatchLevel::Scalar;
+#endif
+}
+
+const BatchKernels& GetBatchKernels(BatchLevel level)
+{
+    static const BatchLevel detected = DetectBatchLevel();
+    if (level > detected)
+        level = detected;
+#ifdef PLANO_BATCH_X86
+    if (level == BatchLevel::AVX2)
+        return s_Avx2;
+    if (level == BatchLevel::SSE2)
+        return s_Sse2;
+#endif
+    return s_Scalar;
+}
+
+const BatchKernels& GetBatchKernels()
+{
+    return GetBatchKernels(BatchLevel::AVX2);
+}
+
+} // inner namespace
+} // outer namespace
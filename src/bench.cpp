@@ -0,0 +1,389 @@
+#include <plano_bench.h>
+#include <internal/internal.h>
+#include <internal/draw_utils.h> // GetIconColor, for generated links
+#include <internal/attribute.h>
+#include <internal/flat_table.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#   include <psapi.h>
+#else
+#   include <sys/resource.h>
+#endif
+
+using namespace plano::types;
+using namespace plano::internal;
+
+// Allocation counting ================================================================================================
+static std::atomic<size_t> s_Allocations(0);
+
+#ifdef PLANO_BENCH_COUNT_ALLOCATIONS
+void* operator new(size_t size)
+{
+    s_Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size)                     { return operator new(size); }
+void  operator delete(void* p) noexcept               { std::free(p); }
+void  operator delete[](void* p) noexcept             { std::free(p); }
+void  operator delete(void* p, size_t) noexcept       { std::free(p); }
+void  operator delete[](void* p, size_t) noexcept     { std::free(p); }
+#endif
+
+namespace plano {
+namespace bench {
+
+static size_t PeakResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#   if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss;        // bytes
+#   else
+    return (size_t)usage.ru_maxrss * 1024; // kilobytes
+#   endif
+#endif
+}
+
+static double Seconds(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+static void ClearGraph()
+{
+    s_Session->s_Nodes.clear();
+    s_Session->s_Links.clear();
+    s_Session->s_NextId = 1;
+    InvalidateIdIndex();
+    ResetJournal();
+}
+
+// Benchmark node types ===============================================================================================
+static void InitText(Properties& p)      { p.pstring["format"] = "value = {0}"; p.pint["precision"] = 3; }
+static void InitSink(Properties& p)      { p.pstring["path"] = "out/result.bin"; p.pbool["enabled"] = true; }
+static void DrawNothing(Properties&)     { }
+
+void RegisterBenchmarkNodes()
+{
+    api::NodeDescription source;
+    source.Type = "Bench Source";
+    source.Outputs.emplace_back("Value", PinType::Float);
+    source.Outputs.emplace_back("Count", PinType::Int);
+    source.Schema.emplace_back("value", 1.0f);
+    source.Schema.emplace_back("seed", 7);
+    source.DrawAndEditProperties = DrawNothing;
+    api::RegisterNewNode(source);
+
+    api::NodeDescription math;
+    math.Type = "Bench Math";
+    math.Inputs.emplace_back("A", PinType::Float);
+    math.Inputs.emplace_back("B", PinType::Float);
+    math.Inputs.emplace_back("Enable", PinType::Bool);
+    math.Outputs.emplace_back("Result", PinType::Float);
+    math.Outputs.emplace_back("Valid", PinType::Bool);
+    math.Schema.emplace_back("operation", 0);
+    math.Schema.emplace_back("scale", 1.0f);
+    math.Schema.emplace_back("clamp", false);
+    math.Schema.emplace_back("label", "");
+    math.DrawAndEditProperties = DrawNothing;
+    api::RegisterNewNode(math);
+
+    api::NodeDescription text;
+    text.Type = "Bench Text";
+    text.Inputs.emplace_back("Value", PinType::Float);
+    text.Inputs.emplace_back("Count", PinType::Int);
+    text.Outputs.emplace_back("Text", PinType::String);
+    text.InitializeDefaultProperties = InitText;
+    text.DrawAndEditProperties = DrawNothing;
+    api::RegisterNewNode(text);
+
+    api::NodeDescription sink;
+    sink.Type = "Bench Sink";
+    sink.Inputs.emplace_back("Text", PinType::String);
+    sink.Inputs.emplace_back("Value", PinType::Float);
+    sink.InitializeDefaultProperties = InitSink;
+    sink.DrawAndEditProperties = DrawNothing;
+    api::RegisterNewNode(sink);
+}
+
+// Project generation =================================================================================================
+void GenerateSyntheticProject(const SyntheticProject& project)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    assert(s_Session->Registry->Count() > 0); // Register some node types first, eg. RegisterBenchmarkNodes()
+
+    ClearGraph();
+
+    std::vector<std::string> types;
+    for (const RegisteredType* type : s_Session->Registry->SortedByName())
+        types.push_back(type->Description.Type);
+
+    std::mt19937 rng(project.Seed);
+    s_Session->s_Nodes.reserve(project.NodeCount);
+    for (size_t i = 0; i < project.NodeCount; i++)
+    {
+        Node* node = NewRegistryNode(types[rng() % types.size()]);
+
+        auto& props = GetProperties(*node);
+        for (int p = 0; p < project.ExtraProperties; p++)
+        {
+            std::string key = "extra" + std::to_string(p);
+            switch (p % 4) {
+                case 0: props.pint[key] = (int)(rng() % 1000);                       break;
+                case 1: props.pfloat[key] = (float)(rng() % 100000) / 1000.0f;       break;
+                case 2: props.pbool[key] = (rng() & 1) != 0;                          break;
+                case 3: props.pstring[key] = "text " + std::to_string(rng() % 100);   break;
+            }
+        }
+    }
+    BuildNodes();
+
+    // Links run from an output of an earlier node to a free, matching input of a later one.
+    std::vector<char> input_used;
+    std::vector<size_t> first_input(project.NodeCount + 1, 0);
+    for (size_t i = 0; i < project.NodeCount; i++)
+        first_input[i + 1] = first_input[i] + s_Session->s_Nodes[i].Inputs.size();
+    input_used.resize(first_input.back(), 0);
+
+    size_t wanted = (size_t)(project.LinksPerNode * project.NodeCount);
+    for (size_t attempt = 0; attempt < wanted * 4 && s_Session->s_Links.size() < wanted && project.NodeCount > 1; attempt++)
+    {
+        size_t to = 1 + rng() % (project.NodeCount - 1);
+        size_t from = rng() % std::min<size_t>(to, 64) ; // Mostly local links, like real graphs.
+        from = to - 1 - from;
+
+        Node& a = s_Session->s_Nodes[from];
+        Node& b = s_Session->s_Nodes[to];
+        if (a.Outputs.empty() || b.Inputs.empty())
+            continue;
+
+        Pin& out = a.Outputs[rng() % a.Outputs.size()];
+        size_t in_index = rng() % b.Inputs.size();
+        Pin& in = b.Inputs[in_index];
+        if (in.Type != out.Type || input_used[first_input[to] + in_index])
+            continue;
+
+        input_used[first_input[to] + in_index] = 1;
+        s_Session->s_Links.emplace_back(GetNextId(), out.ID, in.ID);
+        s_Session->s_Links.back().Color = GetIconColor(out.Type);
+    }
+
+    ResetJournal();
+}
+
+// Serializer benchmark ===============================================================================================
+SerializerStats BenchmarkSerializer(const SyntheticProject& project, Format format, int iterations)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+
+    bool compress = s_Session->CompressSaves;
+    bool lazy = s_Session->LazyProperties;
+    bool binary = s_Session->BinaryProperties;
+    s_Session->CompressSaves = format == Format::Compressed;
+    s_Session->LazyProperties = format == Format::TextLazyLoad;
+    s_Session->BinaryProperties = format == Format::Binary;
+
+    GenerateSyntheticProject(project);
+
+    SerializerStats stats;
+    stats.Nodes = s_Session->s_Nodes.size();
+    stats.Links = s_Session->s_Links.size();
+    stats.SaveSeconds = stats.LoadSeconds = 1e30;
+
+    std::string saved;
+    for (int i = 0; i < iterations; i++)
+    {
+        size_t size;
+        size_t allocations = s_Allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        char* buffer = api::SaveNodesAndLinksToBuffer(&size);
+        stats.SaveSeconds = std::min(stats.SaveSeconds, Seconds(start));
+        stats.SaveAllocations = s_Allocations.load() - allocations;
+
+        saved.assign(buffer, size);
+        delete[] buffer;
+    }
+    stats.Bytes = saved.size();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        ClearGraph();
+        size_t allocations = s_Allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        api::LoadNodesAndLinksFromBuffer(saved.size(), saved.data());
+        stats.LoadSeconds = std::min(stats.LoadSeconds, Seconds(start));
+        stats.LoadAllocations = s_Allocations.load() - allocations;
+    }
+
+    size_t size;
+    char* again = api::SaveNodesAndLinksToBuffer(&size);
+    stats.RoundTrip = saved.size() == size && std::equal(saved.begin(), saved.end(), again);
+    delete[] again;
+
+    double megabytes = (double)stats.Bytes / (1024.0 * 1024.0);
+    stats.SaveMBPerSecond = stats.SaveSeconds > 0.0 ? megabytes / stats.SaveSeconds : 0.0;
+    stats.LoadMBPerSecond = stats.LoadSeconds > 0.0 ? megabytes / stats.LoadSeconds : 0.0;
+    stats.PeakResidentBytes = PeakResidentBytes();
+
+    s_Session->CompressSaves = compress;
+    s_Session->LazyProperties = lazy;
+    s_Session->BinaryProperties = binary;
+    return stats;
+}
+
+// Loader fuzzing =====================================================================================================
+static void Mutate(std::string& data, std::mt19937& rng)
+{
+    if (data.empty()) {
+        data.push_back((char)rng());
+        return;
+    }
+
+    switch (rng() % 6)
+    {
+        case 0: // flip a bit
+            data[rng() % data.size()] ^= (char)(1 << (rng() % 8));
+            break;
+        case 1: // truncate
+            data.resize(rng() % data.size());
+            break;
+        case 2: // insert garbage bytes
+            data.insert(rng() % data.size(), std::string(1 + rng() % 8, (char)rng()));
+            break;
+        case 3: { // drop a line
+            size_t at = data.find('\n', rng() % data.size());
+            size_t end = at == std::string::npos ? std::string::npos : data.find('\n', at + 1);
+            if (at != std::string::npos)
+                data.erase(at, end == std::string::npos ? std::string::npos : end - at);
+            break;
+        }
+        case 4: { // duplicate a line
+            size_t at = data.find('\n', rng() % data.size());
+            size_t end = at == std::string::npos ? std::string::npos : data.find('\n', at + 1);
+            if (end != std::string::npos)
+                data.insert(at, data.substr(at, end - at));
+            break;
+        }
+        case 5: { // replace a number with a hostile one
+            static const char* numbers[] = { "-1", "0", "2147483647", "99999999999999999999", "x", "", "1e9", "-2147483648" };
+            size_t at = data.find('\n', rng() % data.size());
+            size_t end = at == std::string::npos ? std::string::npos : data.find('\n', at + 1);
+            if (end != std::string::npos)
+                data.replace(at + 1, end - at - 1, numbers[rng() % 8]);
+            break;
+        }
+    }
+}
+
+FuzzStats FuzzLoader(const char* buffer, size_t size, size_t iterations, unsigned seed)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+
+    FuzzStats stats;
+    std::mt19937 rng(seed);
+    std::string original(buffer, size);
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        std::string mutated = original;
+        for (unsigned m = 0, count = 1 + rng() % 4; m < count; m++)
+            Mutate(mutated, rng);
+
+        ClearGraph();
+        stats.Runs++;
+        try {
+            if (api::LoadNodesAndLinksFromBuffer(mutated.size(), mutated.data()))
+                stats.Accepted++;
+            else
+                stats.Rejected++;
+        } catch (...) {
+            stats.Exceptions++;
+        }
+    }
+
+    ClearGraph();
+    return stats;
+}
+
+// Property tables ====================================================================================================
+template <typename Table>
+static PropertyTableStats BenchmarkPropertyTable(size_t tables, size_t keys, size_t lookups)
+{
+    PropertyTableStats stats;
+    std::vector<std::string> names;
+    for (size_t k = 0; k < keys; k++)
+        names.push_back(std::string(k % 2 ? "dragData" : "radioData") + std::to_string(k));
+
+    std::vector<Table> all(tables);
+    auto start = std::chrono::steady_clock::now();
+    for (auto& table : all) {
+        for (size_t k = 0; k < keys; k++) {
+            switch (k % 4) {
+                case 0: table.pint[names[k]] = (int)k;              break;
+                case 1: table.pfloat[names[k]] = (float)k;          break;
+                case 2: table.pbool[names[k]] = true;               break;
+                case 3: table.pstring[names[k]] = names[k];         break;
+            }
+        }
+    }
+    stats.InsertSeconds = Seconds(start);
+
+    // Widget code looks keys up with literals (const char*), so time that overload.
+    volatile int sink = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        size_t k = (i * 4) % keys;
+        sink = sink + all[i % tables].pint[names[k].c_str()];
+    }
+    stats.LookupSeconds = Seconds(start);
+
+    std::vector<prop_key> handles;
+    for (auto& name : names)
+        handles.push_back(prop_intern(name));
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        size_t k = (i * 4) % keys;
+        sink = sink + all[i % tables].pint[handles[k]];
+    }
+    stats.KeyLookupSeconds = Seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    for (auto& table : all) {
+        unsigned long entries;
+        std::string text = Prop_Serialize(table, entries);
+        Prop_Deserialize(table, text);
+    }
+    stats.SerializeSeconds = Seconds(start);
+    return stats;
+}
+
+void BenchmarkPropertyTables(size_t tables, size_t keys, size_t lookups, PropertyTableStats& attr, PropertyTableStats& flat)
+{
+    if (tables == 0 || keys == 0)
+        return;
+    attr = BenchmarkPropertyTable<attr_table>(tables, keys, lookups);
+    flat = BenchmarkPropertyTable<flat_table>(tables, keys, lookups);
+}
+
+} // end bench namespace
+} // end plano namespace
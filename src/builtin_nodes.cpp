@@ -0,0 +1,228 @@
+#include <internal/internal.h>
+#include <internal/batch_kernels.h>
+
+using namespace plano::types;
+using namespace plano::internal;
+
+namespace plano {
+namespace api {
+
+// Built-in node types ================================================================================================
+// Each has a scalar Evaluate, which runs the plain kernel on one value so both paths agree to the bit, and an
+// EvaluateBatch that runs the best kernel for the CPU over the whole batch.
+
+static void DrawNothing(Properties&) { }
+
+template <BatchMath Op>
+static void FloatMath(const Properties&, const Value* const* in, Value* out)
+{
+    float result;
+    GetBatchKernels(BatchLevel::Scalar).FloatMath[Op](&in[0]->Float, &in[1]->Float, &result, 1);
+    out[0] = Value(result);
+}
+
+template <BatchMath Op>
+static void FloatMathBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)
+{
+    GetBatchKernels().FloatMath[Op](in[0].As<float>(), in[1].As<float>(), out[0].As<float>(), out[0].Count);
+}
+
+template <BatchMath Op>
+static void IntMath(const Properties&, const Value* const* in, Value* out)
+{
+    int result;
+    GetBatchKernels(BatchLevel::Scalar).IntMath[Op](&in[0]->Int, &in[1]->Int, &result, 1);
+    out[0] = Value(result);
+}
+
+template <BatchMath Op>
+static void IntMathBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)
+{
+    GetBatchKernels().IntMath[Op](in[0].As<int>(), in[1].As<int>(), out[0].As<int>(), out[0].Count);
+}
+
+template <BatchCompare Op>
+static void FloatCompare(const Properties&, const Value* const* in, Value* out)
+{
+    bool result;
+    GetBatchKernels(BatchLevel::Scalar).FloatCompare[Op](&in[0]->Float, &in[1]->Float, &result, 1);
+    out[0] = Value(result);
+}
+
+template <BatchCompare Op>
+static void FloatCompareBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)
+{
+    GetBatchKernels().FloatCompare[Op](in[0].As<float>(), in[1].As<float>(), out[0].As<bool>(), out[0].Count);
+}
+
+template <BatchCompare Op>
+static void IntCompare(const Properties&, const Value* const* in, Value* out)
+{
+    bool result;
+    GetBatchKernels(BatchLevel::Scalar).IntCompare[Op](&in[0]->Int, &in[1]->Int, &result, 1);
+    out[0] = Value(result);
+}
+
+template <BatchCompare Op>
+static void IntCompareBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)
+{
+    GetBatchKernels().IntCompare[Op](in[0].As<int>(), in[1].As<int>(), out[0].As<bool>(), out[0].Count);
+}
+
+static void FloatSelect(const Properties&, const Value* const* in, Value* out)      { out[0] = Value(in[0]->Bool ? in[1]->Float : in[2]->Float); }
+static void IntSelect(const Properties&, const Value* const* in, Value* out)        { out[0] = Value(in[0]->Bool ? in[1]->Int : in[2]->Int); }
+static void BoolAnd(const Properties&, const Value* const* in, Value* out)          { out[0] = Value(in[0]->Bool && in[1]->Bool); }
+static void BoolOr(const Properties&, const Value* const* in, Value* out)           { out[0] = Value(in[0]->Bool || in[1]->Bool); }
+static void BoolNot(const Properties&, const Value* const* in, Value* out)          { out[0] = Value(!in[0]->Bool); }
+
+static void FloatSelectBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)
+{
+    GetBatchKernels().FloatSelect(in[0].As<bool>(), in[1].As<float>(), in[2].As<float>(), out[0].As<float>(), out[0].Count);
+}
+
+static void IntSelectBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)
+{
+    GetBatchKernels().IntSelect(in[0].As<bool>(), in[1].As<int>(), in[2].As<int>(), out[0].As<int>(), out[0].Count);
+}
+
+static void BoolAndBatch(const Properties&, const ValueSpan* in, const ValueSpan* out) { GetBatchKernels().And(in[0].As<bool>(), in[1].As<bool>(), out[0].As<bool>(), out[0].Count); }
+static void BoolOrBatch(const Properties&, const ValueSpan* in, const ValueSpan* out)  { GetBatchKernels().Or(in[0].As<bool>(), in[1].As<bool>(), out[0].As<bool>(), out[0].Count); }
+static void BoolNotBatch(const Properties&, const ValueSpan* in, const ValueSpan* out) { GetBatchKernels().Not(in[0].As<bool>(), out[0].As<bool>(), out[0].Count); }
+
+typedef void (*EvaluateFunction)(const Properties&, const Value* const*, Value*);
+typedef void (*EvaluateBatchFunction)(const Properties&, const ValueSpan*, const ValueSpan*);
+
+static void RegisterBuiltin(NodeRegistry* registry, const std::string& type, std::vector<PinDescription> inputs, PinType result,
+                            EvaluateFunction evaluate, EvaluateBatchFunction evaluate_batch)
+{
+    NodeDescription node;
+    node.Type = type;
+    node.Inputs = std::move(inputs);
+    node.Outputs.emplace_back("Result", result);
+    node.Color = ImColor(120, 200, 255);
+    node.DrawAndEditProperties = DrawNothing;
+    node.Evaluate = evaluate;
+    node.EvaluateBatch = evaluate_batch;
+    if (registry)
+        RegisterNewNode(registry, node);
+    else
+        RegisterNewNode(node);
+}
+
+// Flow nodes.  Latent ones are state machines over Execution::Step: 0 when the flow comes in, 1 once it resumes.
+
+static FlowAction Branch(Execution&, const Properties&, const Value* const* in, Value*)
+{
+    return FlowAction::Continue(in[1]->Bool ? 0 : 1);
+}
+
+static FlowAction Delay(Execution& run, const Properties&, const Value* const* in, Value*)
+{
+    if (run.Step == 0) {
+        run.Step = 1;
+        return FlowAction::Sleep(in[1]->Float);
+    }
+    return FlowAction::Continue(0);
+}
+
+static FlowAction WaitForSignal(Execution& run, const Properties&, const Value* const* in, Value*)
+{
+    if (run.Step == 0) {
+        run.Step = 1;
+        return FlowAction::WaitFor(in[1]->String.c_str());
+    }
+    return FlowAction::Continue(0);
+}
+
+// "Then" goes on right away; "Tick" fires every Seconds, once or until the node is deleted.
+static FlowAction SetTimer(Execution& run, const Properties&, const Value* const* in, Value*)
+{
+    if (run.Step == 0) {
+        run.Step = 1;
+        run.Fork = 0;
+        return FlowAction::Sleep(in[1]->Float);
+    }
+    run.Fork = 1;
+    return in[2]->Bool ? FlowAction::Sleep(in[1]->Float) : FlowAction::End();
+}
+
+typedef FlowAction (*ExecuteFunction)(Execution&, const Properties&, const Value* const*, Value*);
+
+static void RegisterFlow(NodeRegistry* registry, const std::string& type, std::vector<PinDescription> inputs, std::vector<PinDescription> outputs,
+                         ExecuteFunction execute)
+{
+    NodeDescription node;
+    node.Type = type;
+    node.Inputs.emplace_back("In", PinType::Flow);
+    for (auto& input : inputs)
+        node.Inputs.push_back(std::move(input));
+    node.Outputs = std::move(outputs);
+    node.Color = ImColor(255, 255, 255);
+    node.DrawAndEditProperties = DrawNothing;
+    node.Execute = execute;
+    if (registry)
+        RegisterNewNode(registry, node);
+    else
+        RegisterNewNode(node);
+}
+
+void RegisterBuiltinNodes(NodeRegistry* registry)
+{
+    static const char* math[BatchMathCount] = { "Add", "Subtract", "Multiply", "Divide", "Min", "Max" };
+    static const EvaluateFunction float_math[BatchMathCount] = {
+        FloatMath<BatchAdd>, FloatMath<BatchSubtract>, FloatMath<BatchMultiply>, FloatMath<BatchDivide>,
+        FloatMath<BatchMin>, FloatMath<BatchMax> };
+    static const EvaluateBatchFunction float_math_batch[BatchMathCount] = {
+        FloatMathBatch<BatchAdd>, FloatMathBatch<BatchSubtract>, FloatMathBatch<BatchMultiply>,
+        FloatMathBatch<BatchDivide>, FloatMathBatch<BatchMin>, FloatMathBatch<BatchMax> };
+    static const EvaluateFunction int_math[BatchMathCount] = {
+        IntMath<BatchAdd>, IntMath<BatchSubtract>, IntMath<BatchMultiply>, IntMath<BatchDivide>,
+        IntMath<BatchMin>, IntMath<BatchMax> };
+    static const EvaluateBatchFunction int_math_batch[BatchMathCount] = {
+        IntMathBatch<BatchAdd>, IntMathBatch<BatchSubtract>, IntMathBatch<BatchMultiply>,
+        IntMathBatch<BatchDivide>, IntMathBatch<BatchMin>, IntMathBatch<BatchMax> };
+    for (int op = 0; op < BatchMathCount; op++) {
+        RegisterBuiltin(registry, std::string("Float ") + math[op], { { "A", PinType::Float }, { "B", PinType::Float } },
+                        PinType::Float, float_math[op], float_math_batch[op]);
+        RegisterBuiltin(registry, std::string("Int ") + math[op], { { "A", PinType::Int }, { "B", PinType::Int } },
+                        PinType::Int, int_math[op], int_math_batch[op]);
+    }
+
+    static const char* compare[BatchCompareCount] = { "Less", "Greater", "Equal" };
+    static const EvaluateFunction float_compare[BatchCompareCount] = {
+        FloatCompare<BatchLess>, FloatCompare<BatchGreater>, FloatCompare<BatchEqual> };
+    static const EvaluateBatchFunction float_compare_batch[BatchCompareCount] = {
+        FloatCompareBatch<BatchLess>, FloatCompareBatch<BatchGreater>, FloatCompareBatch<BatchEqual> };
+    static const EvaluateFunction int_compare[BatchCompareCount] = {
+        IntCompare<BatchLess>, IntCompare<BatchGreater>, IntCompare<BatchEqual> };
+    static const EvaluateBatchFunction int_compare_batch[BatchCompareCount] = {
+        IntCompareBatch<BatchLess>, IntCompareBatch<BatchGreater>, IntCompareBatch<BatchEqual> };
+    for (int op = 0; op < BatchCompareCount; op++) {
+        RegisterBuiltin(registry, std::string("Float ") + compare[op], { { "A", PinType::Float }, { "B", PinType::Float } },
+                        PinType::Bool, float_compare[op], float_compare_batch[op]);
+        RegisterBuiltin(registry, std::string("Int ") + compare[op], { { "A", PinType::Int }, { "B", PinType::Int } },
+                        PinType::Bool, int_compare[op], int_compare_batch[op]);
+    }
+
+    RegisterBuiltin(registry, "Float Select", { { "Condition", PinType::Bool }, { "True", PinType::Float }, { "False", PinType::Float } },
+                    PinType::Float, FloatSelect, FloatSelectBatch);
+    RegisterBuiltin(registry, "Int Select", { { "Condition", PinType::Bool }, { "True", PinType::Int }, { "False", PinType::Int } },
+                    PinType::Int, IntSelect, IntSelectBatch);
+    RegisterBuiltin(registry, "Bool And", { { "A", PinType::Bool }, { "B", PinType::Bool } }, PinType::Bool, BoolAnd, BoolAndBatch);
+    RegisterBuiltin(registry, "Bool Or", { { "A", PinType::Bool }, { "B", PinType::Bool } }, PinType::Bool, BoolOr, BoolOrBatch);
+    RegisterBuiltin(registry, "Bool Not", { { "A", PinType::Bool } }, PinType::Bool, BoolNot, BoolNotBatch);
+
+    RegisterFlow(registry, "Branch", { { "Condition", PinType::Bool } }, { { "True", PinType::Flow }, { "False", PinType::Flow } }, Branch);
+    RegisterFlow(registry, "Delay", { { "Seconds", PinType::Float } }, { { "Completed", PinType::Flow } }, Delay);
+    RegisterFlow(registry, "Wait For Signal", { { "Signal", PinType::String } }, { { "Then", PinType::Flow } }, WaitForSignal);
+    RegisterFlow(registry, "Set Timer", { { "Seconds", PinType::Float }, { "Looping", PinType::Bool } },
+                 { { "Then", PinType::Flow }, { "Tick", PinType::Flow } }, SetTimer);
+}
+
+const char* GetBatchKernelSet()
+{
+    return GetBatchKernels().Name;
+}
+
+} // inner namespace
+} // outer namespace
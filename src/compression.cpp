@@ -0,0 +1,352 @@
+#include <internal/compression.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace plano {
+namespace internal {
+
+static const char     FrameMagic[4]  = { 'P', 'L', 'Z', '1' };
+static const uint32_t StoredRawFlag  = 0x80000000u;
+
+// LZ4 block format limits.
+static const size_t MinMatch     = 4;
+static const size_t LastLiterals = 5;  // The last 5 bytes of a block are always literals.
+static const size_t MatchLimit   = 12; // A match can't start in the last 12 bytes of a block.
+static const int    HashBits     = 12;
+
+// Each byte of a block adds at most 255 bytes of match length, so no chunk inflates by more than this.  Sizes in a
+// header that claim more are corrupt, and are refused before anything is allocated for them.
+static const size_t MaxExpansion = 255;
+
+// Below this many chunks, spawning threads costs more than it saves.
+static const size_t ParallelChunkCount = 4;
+
+static uint32_t Read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void PutU32(std::string& out, uint32_t v)
+{
+    unsigned char b[4] = { (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+    out.append((const char*)b, 4);
+}
+
+static uint32_t GetU32(const char* p)
+{
+    const unsigned char* b = (const unsigned char*)p;
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static unsigned char* PutLength(unsigned char* op, size_t len)
+{
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+// Worst case output size of CompressBlock for n input bytes.
+static size_t CompressBound(size_t n)
+{
+    return n + n / 255 + 16;
+}
+
+// Greedy single-probe LZ4 block compressor.  Returns the compressed size.
+static size_t CompressBlock(const unsigned char* src, size_t n, unsigned char* dst)
+{
+    int table[1 << HashBits];
+    std::fill(table, table + (1 << HashBits), -1);
+
+    unsigned char* op = dst;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    if (n > MatchLimit)
+    {
+        const size_t limit = n - MatchLimit;
+        while (ip < limit)
+        {
+            uint32_t seq = Read32(src + ip);
+            uint32_t h = (seq * 2654435761u) >> (32 - HashBits);
+            int ref = table[h];
+            table[h] = (int)ip;
+
+            if (ref < 0 || ip - (size_t)ref > 0xFFFF || Read32(src + ref) != seq)
+            {
+                ip++;
+                continue;
+            }
+
+            // Stretch the match backwards over literals we haven't written yet, then forwards.
+            size_t match = (size_t)ref;
+            while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1]) {
+                ip--;
+                match--;
+            }
+            size_t len = MinMatch;
+            const size_t max_len = n - LastLiterals - ip;
+            while (len < max_len && src[ip + len] == src[match + len])
+                len++;
+
+            // Sequence: token, literal length, literals, offset, match length.
+            size_t literals = ip - anchor;
+            unsigned char* token = op++;
+            *token = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+            if (literals >= 15)
+                op = PutLength(op, literals - 15);
+            memcpy(op, src + anchor, literals);
+            op += literals;
+
+            size_t offset = ip - match;
+            *op++ = (unsigned char)offset;
+            *op++ = (unsigned char)(offset >> 8);
+
+            size_t extra = len - MinMatch;
+            *token |= (unsigned char)(extra >= 15 ? 15 : extra);
+            if (extra >= 15)
+                op = PutLength(op, extra - 15);
+
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    // Last sequence is literals only.
+    size_t literals = n - anchor;
+    *op++ = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+    if (literals >= 15)
+        op = PutLength(op, literals - 15);
+    memcpy(op, src + anchor, literals);
+    op += literals;
+
+    return (size_t)(op - dst);
+}
+
+// Bounds-checked LZ4 block decompressor.  dst must hold exactly raw_size bytes.
+static bool DecompressBlock(const unsigned char* src, size_t n, unsigned char* dst, size_t raw_size)
+{
+    const unsigned char* ip = src;
+    const unsigned char* const iend = src + n;
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + raw_size;
+
+    while (ip < iend)
+    {
+        unsigned token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend)
+                    return false;
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+        if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals)
+            return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        if (ip == iend)
+            break; // Last sequence has no match.
+
+        if (iend - ip < 2)
+            return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return false;
+
+        size_t len = token & 15;
+        if (len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend)
+                    return false;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += MinMatch;
+        if ((size_t)(oend - op) < len)
+            return false;
+
+        // Matches may overlap their own output (offset < len), so copy byte by byte.
+        const unsigned char* match = op - offset;
+        for (size_t i = 0; i < len; i++)
+            op[i] = match[i];
+        op += len;
+    }
+
+    return op == oend;
+}
+
+// Runs fn(0..count-1), spread over the hardware threads when there is enough work.
+template <typename Fn>
+static void ParallelFor(size_t count, Fn fn)
+{
+    size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), count);
+    if (count < ParallelChunkCount || threads < 2) {
+        for (size_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++)
+        pool.emplace_back([=]() {
+            for (size_t i = t; i < count; i += threads)
+                fn(i);
+        });
+    for (auto& thread : pool)
+        thread.join();
+}
+
+// Parsed frame header.  Payload offsets are relative to the start of the frame.
+struct FrameIndex {
+    std::vector<uint32_t> RawSizes;
+    std::vector<uint32_t> StoredSizes;
+    std::vector<size_t>   Offsets;
+    size_t                FrameSize = 0;
+    size_t                RawSize = 0;
+};
+
+static bool ReadFrameIndex(const char* data, size_t size, FrameIndex& index)
+{
+    if (!IsCompressedFrame(data, size) || size < 8)
+        return false;
+
+    size_t count = GetU32(data + 4);
+    if (count > (size - 8) / 8)
+        return false;
+
+    index.RawSizes.resize(count);
+    index.StoredSizes.resize(count);
+    index.Offsets.resize(count);
+
+    size_t offset = 8 + count * 8;
+    for (size_t i = 0; i < count; i++)
+    {
+        index.RawSizes[i]    = GetU32(data + 8 + i * 8);
+        index.StoredSizes[i] = GetU32(data + 12 + i * 8);
+        index.Offsets[i]     = offset;
+
+        size_t stored = index.StoredSizes[i] & ~StoredRawFlag;
+        if (index.RawSizes[i] > CompressionChunkSize || stored > size - offset)
+            return false;
+        if ((index.StoredSizes[i] & StoredRawFlag) && stored != index.RawSizes[i])
+            return false;
+        if (!(index.StoredSizes[i] & StoredRawFlag) && (stored == 0 || index.RawSizes[i] > stored * MaxExpansion))
+            return false;
+
+        offset += stored;
+        index.RawSize += index.RawSizes[i];
+    }
+    index.FrameSize = offset;
+    return true;
+}
+
+static bool DecompressIndexedChunk(const char* frame, const FrameIndex& index, size_t i, char* dst)
+{
+    const char* src = frame + index.Offsets[i];
+    if (index.StoredSizes[i] & StoredRawFlag) {
+        memcpy(dst, src, index.RawSizes[i]);
+        return true;
+    }
+    return DecompressBlock((const unsigned char*)src, index.StoredSizes[i], (unsigned char*)dst, index.RawSizes[i]);
+}
+
+bool IsCompressedFrame(const char* data, size_t size)
+{
+    return size >= sizeof(FrameMagic) && memcmp(data, FrameMagic, sizeof(FrameMagic)) == 0;
+}
+
+std::string CompressFrame(const char* data, size_t size)
+{
+    size_t count = (size + CompressionChunkSize - 1) / CompressionChunkSize;
+
+    // Chunks are compressed into scratch buffers in parallel, then stitched together behind the header.
+    std::vector<std::string> chunks(count);
+    ParallelFor(count, [&](size_t i) {
+        size_t raw = std::min(CompressionChunkSize, size - i * CompressionChunkSize);
+        const unsigned char* src = (const unsigned char*)data + i * CompressionChunkSize;
+        std::string& chunk = chunks[i];
+        chunk.resize(CompressBound(raw));
+        chunk.resize(CompressBlock(src, raw, (unsigned char*)&chunk[0]));
+        if (chunk.size() >= raw) // Incompressible, store it as is.
+            chunk.assign((const char*)src, raw);
+    });
+
+    std::string out(FrameMagic, sizeof(FrameMagic));
+    PutU32(out, (uint32_t)count);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t raw = (uint32_t)std::min(CompressionChunkSize, size - i * CompressionChunkSize);
+        uint32_t stored = (uint32_t)chunks[i].size();
+        PutU32(out, raw);
+        PutU32(out, stored == raw ? (stored | StoredRawFlag) : stored);
+    }
+    for (auto& chunk : chunks)
+        out.append(chunk);
+    return out;
+}
+
+bool DecompressFrames(const char* data, size_t size, std::string& out)
+{
+    out.clear();
+    while (size > 0)
+    {
+        FrameIndex index;
+        if (!ReadFrameIndex(data, size, index))
+            return false;
+
+        if (index.RawSize > index.FrameSize * MaxExpansion)
+            return false;
+        size_t base = out.size();
+        out.resize(base + index.RawSize);
+
+        std::vector<size_t> dst(index.RawSizes.size());
+        for (size_t i = 0, at = base; i < dst.size(); at += index.RawSizes[i++])
+            dst[i] = at;
+
+        std::vector<char> ok(dst.size(), 0);
+        ParallelFor(dst.size(), [&](size_t i) {
+            ok[i] = DecompressIndexedChunk(data, index, i, &out[dst[i]]);
+        });
+        if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+            return false;
+
+        data += index.FrameSize;
+        size -= index.FrameSize;
+    }
+    return true;
+}
+
+size_t ChunkCount(const char* frame, size_t size)
+{
+    FrameIndex index;
+    return ReadFrameIndex(frame, size, index) ? index.RawSizes.size() : 0;
+}
+
+bool DecompressChunk(const char* frame, size_t size, size_t i, std::string& out)
+{
+    FrameIndex index;
+    if (!ReadFrameIndex(frame, size, index) || i >= index.RawSizes.size())
+        return false;
+
+    out.resize(index.RawSizes[i]);
+    return DecompressIndexedChunk(frame, index, i, &out[0]);
+}
+
+} // inner namespace
+} // outer namespace
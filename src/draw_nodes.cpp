@@ -126,11 +126,18 @@ void draw_blueprint_style(Pin* newLinkPin)
                 ImGui::Spring(1, 0);
             } else {
                 builder.Middle();
-                if(s_Session->NodeRegistry.count(node.Name) > 0){
-                    s_Session->NodeRegistry[node.Name].DrawAndEditProperties(node.Properties);
+                // The table logs the keys its draw callback is handed, and nodes sharing their defaults are drawn
+                // from a copy (see tracking.h).
+                // The group lets us ask ImGui whether any of the node's widgets were edited.
+                Properties& properties = BeginNodeProperties(node);
+                ImGui::BeginGroup();
+                if(const RegisteredType* type = FindNodeType(node.Name)){
+                    type->Description.DrawAndEditProperties(properties);
                 }else{
-                    im_draw_basic_widgets(node.Properties);
+                    im_draw_basic_widgets(properties);
                 }
+                ImGui::EndGroup();
+                EndNodeProperties(node, ImGui::IsItemEdited());
             }
 
             // output column.
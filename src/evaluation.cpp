@@ -0,0 +1,517 @@
+#include <internal/evaluation.h>
+#include <internal/internal.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <queue>
+
+using namespace plano::types;
+namespace ed = ax::NodeEditor;
+
+namespace plano {
+namespace internal {
+
+// Flow, Function and Delegate links order or reference nodes; they don't carry values.
+static bool CarriesValue(PinType type)
+{
+    switch (type) {
+        case PinType::Bool:
+        case PinType::Int:
+        case PinType::Float:
+        case PinType::String:
+        case PinType::Object:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void StructureChanged()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    s_Session->Evaluation.Structure++;
+}
+
+// What a rebuild keeps of the schedule it replaces.
+struct PreviousSchedule {
+    std::vector<EvaluationStep>             Steps;
+    std::vector<Value>                      Values;
+    std::vector<uintptr_t>                  SlotPins;
+    std::unordered_map<uintptr_t, uint32_t> PinSlots;
+    std::vector<unsigned long long>         Evaluated;
+    std::vector<uint8_t>                    Dirty;
+    uint32_t                                FirstInputSlot = 0;
+
+    // The output pin an input pin read, 0 if it was unlinked or didn't exist.
+    uintptr_t Source(uintptr_t input) const {
+        auto slot = PinSlots.find(input);
+        return slot != PinSlots.end() && slot->second < FirstInputSlot ? SlotPins[slot->second] : 0;
+    }
+};
+
+// Outputs keep their values, and steps of nodes that were already scheduled keep their state, unless one of
+// their inputs now reads another pin.  New steps start dirty.
+static void CarryOver(EvaluationState& eval, const PreviousSchedule& previous)
+{
+    for (uint32_t slot = 0; slot < eval.FirstInputSlot; slot++) {
+        auto old = previous.PinSlots.find(eval.SlotPins[slot]);
+        if (old != previous.PinSlots.end())
+            eval.Values[slot] = previous.Values[old->second];
+    }
+
+    std::unordered_map<uintptr_t, uint32_t> old_steps;
+    for (uint32_t s = 0; s < previous.Steps.size(); s++)
+        old_steps.emplace(previous.Steps[s].Id, s);
+
+    auto& nodes = s_Session->s_Nodes;
+    eval.Evaluated.assign(eval.Steps.size(), 0);
+    eval.Dirty.assign(eval.Steps.size(), 1);
+    for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+        auto old = old_steps.find(eval.Steps[s].Id);
+        if (old == old_steps.end())
+            continue;
+        bool moved = false;
+        const Node& node = nodes[eval.Steps[s].Node];
+        for (size_t i = 0; i < node.Inputs.size() && !moved; i++) {
+            uint32_t slot = eval.Sources[eval.Steps[s].Inputs + i];
+            uintptr_t source = slot < eval.FirstInputSlot ? eval.SlotPins[slot] : 0;
+            moved = source != previous.Source(node.Inputs[i].ID.Get());
+        }
+        eval.Evaluated[s] = previous.Evaluated[old->second];
+        eval.Dirty[s] = moved || previous.Dirty[old->second];
+    }
+}
+
+// Resolves the tape's arguments.  Values doesn't grow until the next rebuild, so the pointers hold until then.
+// Properties are left for EvaluateGraph, which only resolves those of steps that run.
+static void Compile(EvaluationState& eval)
+{
+    eval.Arguments.resize(eval.Sources.size());
+    for (size_t i = 0; i < eval.Sources.size(); i++)
+        eval.Arguments[i] = &eval.Values[eval.Sources[i]];
+}
+
+void BuildSchedule()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& eval = s_Session->Evaluation;
+    if (eval.Built == eval.Structure)
+        return;
+
+    auto& nodes = s_Session->s_Nodes;
+    PreviousSchedule previous;
+    previous.Steps.swap(eval.Steps);
+    previous.Values.swap(eval.Values);
+    previous.SlotPins.swap(eval.SlotPins);
+    previous.PinSlots.swap(eval.PinSlots);
+    previous.Evaluated.swap(eval.Evaluated);
+    previous.Dirty.swap(eval.Dirty);
+    previous.FirstInputSlot = eval.FirstInputSlot;
+    eval.Sources.clear();
+    eval.Tape.clear();
+    eval.Cyclic = false;
+
+    // Every output pin gets a slot, node by node.
+    std::vector<uint32_t>& first_output = eval.FirstOutputs;
+    first_output.assign(nodes.size(), 0);
+    for (size_t n = 0; n < nodes.size(); n++) {
+        first_output[n] = (uint32_t)eval.Values.size();
+        for (auto& pin : nodes[n].Outputs) {
+            eval.PinSlots[pin.ID.Get()] = (uint32_t)eval.Values.size();
+            eval.SlotPins.push_back(pin.ID.Get());
+            eval.Values.emplace_back(pin.Type);
+        }
+    }
+    eval.FirstInputSlot = (uint32_t)eval.Values.size();
+
+    // Each link makes its input pin read its output pin's slot (the first link wins if there are several),
+    // and its end node depend on its start node.
+    std::unordered_map<uintptr_t, uint32_t> linked;
+    std::vector<std::vector<size_t>> downstream(nodes.size());
+    std::vector<size_t> waiting(nodes.size(), 0);
+    for (auto& link : s_Session->s_Links) {
+        const PinSlot* start = FindPinSlot(link.StartPinID);
+        const PinSlot* end = FindPinSlot(link.EndPinID);
+        if (!start || !end || !start->Output || end->Output || !CarriesValue(nodes[start->Node].Outputs[start->Pin].Type))
+            continue;
+        if (!linked.emplace(link.EndPinID.Get(), eval.PinSlots[link.StartPinID.Get()]).second)
+            continue;
+        downstream[start->Node].push_back(end->Node);
+        waiting[end->Node]++;
+    }
+
+    // Inputs, node by node.  Unlinked ones get a slot of their own, holding what SetPinValue gave them.
+    std::vector<uint32_t>& first_input = eval.FirstInputs;
+    first_input.assign(nodes.size(), 0);
+    for (size_t n = 0; n < nodes.size(); n++) {
+        first_input[n] = (uint32_t)eval.Sources.size();
+        for (auto& pin : nodes[n].Inputs) {
+            auto source = linked.find(pin.ID.Get());
+            if (source != linked.end()) {
+                eval.PinSlots[pin.ID.Get()] = source->second;
+                eval.Sources.push_back(source->second);
+                continue;
+            }
+            uint32_t slot = (uint32_t)eval.Values.size();
+            auto given = eval.InputValues.find(pin.ID.Get());
+            if (given != eval.InputValues.end())
+                eval.Values.push_back(given->second);
+            else
+                eval.Values.emplace_back(pin.Type);
+            eval.PinSlots[pin.ID.Get()] = slot;
+            eval.SlotPins.push_back(pin.ID.Get());
+            eval.Sources.push_back(slot);
+        }
+    }
+
+    // Kahn's algorithm, seeded in s_Nodes order so the schedule doesn't depend on anything but the graph.
+    std::deque<size_t> ready;
+    for (size_t n = 0; n < nodes.size(); n++)
+        if (waiting[n] == 0)
+            ready.push_back(n);
+
+    const uint32_t none = UINT32_MAX;
+    std::vector<uint32_t>& step_of = eval.StepOf;
+    step_of.assign(nodes.size(), none);
+    size_t scheduled = 0;
+    while (!ready.empty()) {
+        size_t n = ready.front();
+        ready.pop_front();
+        scheduled++;
+
+        const RegisteredType* type = FindNodeType(nodes[n].Name);
+        const api::NodeDescription* description = type ? &type->Description : nullptr;
+        if (description && description->Evaluate) {
+            step_of[n] = (uint32_t)eval.Steps.size();
+            eval.Steps.push_back(EvaluationStep{ n, nodes[n].ID.Get(), first_input[n], first_output[n], 0, 0, 0,
+                                                 description->MainThreadOnly, description->Pure,
+                                                 description->EvaluateBatch });
+            eval.Tape.push_back(EvaluationInstruction{ description->Evaluate, nullptr, first_input[n],
+                                                       first_output[n] });
+        }
+
+        for (size_t next : downstream[n])
+            if (--waiting[next] == 0)
+                ready.push_back(next);
+    }
+    eval.Cyclic = scheduled < nodes.size();
+
+    // Dependencies between steps, for parallel runs.  Nodes without a step never change their outputs, so
+    // nothing waits for them.
+    eval.Dependents.clear();
+    for (auto& step : eval.Steps) {
+        step.Dependents = (uint32_t)eval.Dependents.size();
+        for (size_t next : downstream[step.Node])
+            if (step_of[next] != none) {
+                eval.Dependents.push_back(step_of[next]);
+                eval.Steps[step_of[next]].Upstream++;
+            }
+        step.DependentCount = (uint32_t)eval.Dependents.size() - step.Dependents;
+    }
+
+    // And the same per node, for anything else that writes a node's outputs (see flow.h).
+    eval.Readers.clear();
+    eval.FirstReaders.resize(nodes.size() + 1);
+    for (size_t n = 0; n < nodes.size(); n++) {
+        eval.FirstReaders[n] = (uint32_t)eval.Readers.size();
+        for (size_t next : downstream[n])
+            if (step_of[next] != none)
+                eval.Readers.push_back(step_of[next]);
+    }
+    eval.FirstReaders[nodes.size()] = (uint32_t)eval.Readers.size();
+    eval.Remaining.reset(new std::atomic<uint32_t>[eval.Steps.size()]);
+    eval.MemoKeys.assign(eval.Steps.size(), std::string());
+    eval.MemoKeyGenerations.assign(eval.Steps.size(), ~0ull);
+    eval.Built = eval.Structure;
+    CarryOver(eval, previous);
+    Compile(eval);
+}
+
+void AppendMemoValue(std::string& key, const Value& value)
+{
+    key.push_back((char)value.Type);
+    switch (value.Type) {
+        case PinType::Bool:   key.push_back(value.Bool ? 1 : 0); break;
+        case PinType::Int:    key.append((const char*)&value.Int, sizeof(value.Int)); break;
+        case PinType::Float:  key.append((const char*)&value.Float, sizeof(value.Float)); break;
+        case PinType::String: {
+            uint32_t size = (uint32_t)value.String.size();
+            key.append((const char*)&size, sizeof(size));
+            key.append(value.String);
+            break;
+        }
+        case PinType::Object: {
+            const void* object = value.Object.get();
+            key.append((const char*)&object, sizeof(object));
+            break;
+        }
+        default: break;
+    }
+}
+
+const std::string& MemoKeyPrefix(uint32_t s)
+{
+    auto& eval = s_Session->Evaluation;
+    const Node& node = s_Session->s_Nodes[eval.Steps[s].Node];
+    if (eval.MemoKeyGenerations[s] != node.PropertyGeneration) {
+        unsigned long entries = 0;
+        eval.MemoKeys[s] = node.Name;
+        eval.MemoKeys[s].push_back('\0');
+        eval.MemoKeys[s] += Prop_Serialize(*eval.Tape[s].Properties, entries);
+        eval.MemoKeyGenerations[s] = node.PropertyGeneration;
+    }
+    return eval.MemoKeys[s];
+}
+
+static void CallStep(EvaluationState& eval, const std::vector<Node>& nodes, uint32_t s, unsigned thread)
+{
+    const EvaluationInstruction& op = eval.Tape[s];
+    const Value* const* arguments = eval.Arguments.data() + op.Arguments;
+    Value* outputs = eval.Values.data() + op.Outputs;
+    if (!eval.Steps[s].Pure || eval.Memo.Capacity() == 0) {
+        op.Evaluate(*op.Properties, arguments, outputs);
+        return;
+    }
+
+    const Node& node = nodes[eval.Steps[s].Node];
+    std::string& key = eval.Keys[thread];
+    key = eval.MemoKeys[s];   // Made by CollectDirtySteps.
+    for (size_t i = 0; i < node.Inputs.size(); i++)
+        AppendMemoValue(key, *arguments[i]);
+
+    uint64_t hash = MemoCache::Hash(key);
+    if (eval.Memo.Find(hash, key, outputs, node.Outputs.size()))
+        return;
+    op.Evaluate(*op.Properties, arguments, outputs);
+    eval.Memo.Insert(hash, key, arguments, node.Inputs.size(), outputs, node.Outputs.size());
+}
+
+static void RunStep(EvaluationState& eval, const std::vector<Node>& nodes, uint32_t s, unsigned thread)
+{
+    if (eval.Timings.empty()) {
+        CallStep(eval, nodes, s, thread);
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    CallStep(eval, nodes, s, thread);
+    eval.Timings[s] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// WorkPool task: one step, then hand over the dependents it was the last wait of.
+static void RunParallelStep(void* user, uint32_t task, unsigned thread)
+{
+    // Pool threads get no current context, only its blob store.  The calling thread waits in Finish meanwhile,
+    // so the nodes hold still.
+    ContextData* session = (ContextData*)user;
+    prop_blob_scope blobs(&session->Blobs);
+    auto& eval = session->Evaluation;
+    const EvaluationStep& step = eval.Steps[task];
+    RunStep(eval, session->s_Nodes, task, thread);
+
+    for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++) {
+        uint32_t next = eval.Dependents[d];
+        if (eval.Remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            eval.Pool->Push(thread, next, eval.Steps[next].MainThreadOnly);
+    }
+}
+
+size_t CollectDirtySteps()
+{
+    BuildSchedule();
+    auto& eval = s_Session->Evaluation;
+    auto& nodes = s_Session->s_Nodes;
+
+    // Steps are in dependency order, so one pass carries dirt all the way down.  Properties and memo keys are
+    // resolved here, on this thread (lazily loaded ones get parsed), so parallel runs only ever read nodes.
+    size_t dirty = 0;
+    for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+        const EvaluationStep& step = eval.Steps[s];
+        if (nodes[step.Node].PropertyGeneration != eval.Evaluated[s]) {
+            eval.Tape[s].Properties = nullptr;
+            eval.Dirty[s] = 1;
+        }
+        if (!eval.Dirty[s])
+            continue;
+        if (!eval.Tape[s].Properties)
+            eval.Tape[s].Properties = &PeekProperties(nodes[step.Node]);
+        if (step.Pure && eval.Memo.Capacity() != 0)
+            MemoKeyPrefix(s);
+        dirty++;
+        for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++)
+            eval.Dirty[eval.Dependents[d]] = 1;
+    }
+    return dirty;
+}
+
+void MarkStepsEvaluated()
+{
+    auto& eval = s_Session->Evaluation;
+    auto& nodes = s_Session->s_Nodes;
+    for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+        eval.Evaluated[s] = nodes[eval.Steps[s].Node].PropertyGeneration;
+        eval.Dirty[s] = 0;
+    }
+}
+
+bool EvaluateGraph()
+{
+    // A run in flight hands its steps back, dirty, so this one covers them.
+    AbandonAsyncEvaluation();
+    size_t dirty = CollectDirtySteps();
+    auto& eval = s_Session->Evaluation;
+    eval.LastRun = dirty;
+    eval.Timings.assign(s_Session->Profiler.Enabled ? eval.Steps.size() : 0, -1.0);
+
+    if (eval.Threads <= 1 || dirty < 2) {
+        eval.Keys.resize(1);
+        for (uint32_t s = 0; s < eval.Steps.size(); s++)
+            if (eval.Dirty[s])
+                RunStep(eval, s_Session->s_Nodes, s, 0);
+    } else {
+        if (!eval.Pool || eval.Pool->Threads() != eval.Threads)
+            eval.Pool.reset(new WorkPool(eval.Threads));
+        eval.Keys.resize(eval.Threads);
+
+        // Every dependent of a dirty step is dirty, so a dirty step waits for the dirty steps feeding it, and
+        // for nothing else.
+        for (uint32_t s = 0; s < eval.Steps.size(); s++)
+            eval.Remaining[s].store(0, std::memory_order_relaxed);
+        for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+            if (!eval.Dirty[s])
+                continue;
+            const EvaluationStep& step = eval.Steps[s];
+            for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++)
+                eval.Remaining[eval.Dependents[d]].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The first steps are picked before any is queued: once one runs, the counts start moving.
+        eval.Ready.clear();
+        for (uint32_t s = 0; s < eval.Steps.size(); s++)
+            if (eval.Dirty[s] && eval.Remaining[s].load(std::memory_order_relaxed) == 0)
+                eval.Ready.push_back(s);
+        eval.Pool->Start(dirty, RunParallelStep, s_Session);
+        for (uint32_t s : eval.Ready)
+            eval.Pool->Push(0, s, eval.Steps[s].MainThreadOnly);
+        eval.Pool->Finish();
+    }
+
+    for (uint32_t s = 0; s < eval.Timings.size(); s++)
+        if (eval.Timings[s] >= 0.0)
+            RecordProfile(eval.Steps[s].Id, eval.Timings[s], eval.Values.data() + eval.Steps[s].Outputs,
+                          s_Session->s_Nodes[eval.Steps[s].Node].Outputs.size());
+    MarkStepsEvaluated();
+    return !eval.Cyclic;
+}
+
+bool EvaluateGraphSlice(double seconds)
+{
+    AbandonAsyncEvaluation();
+    auto start = std::chrono::steady_clock::now();
+    size_t dirty = CollectDirtySteps();
+    auto& eval = s_Session->Evaluation;
+    auto& nodes = s_Session->s_Nodes;
+    eval.LastRun = 0;
+    if (dirty == 0)
+        return !eval.Cyclic;
+
+    // Steps of visible nodes come first, and so do the steps feeding them, or they'd wait anyway.
+    eval.Wanted.assign(eval.Steps.size(), 0);
+    for (uintptr_t id : eval.Visible)
+        if (Node* node = FindNode(ed::NodeId(id)))
+            if (eval.StepOf[node - nodes.data()] != UINT32_MAX)
+                eval.Wanted[eval.StepOf[node - nodes.data()]] = 1;
+    for (uint32_t s = (uint32_t)eval.Steps.size(); s-- > 0;) {
+        const EvaluationStep& step = eval.Steps[s];
+        for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount && !eval.Wanted[s]; d++)
+            eval.Wanted[s] = eval.Wanted[eval.Dependents[d]];
+    }
+
+    // What ran in earlier slices is clean now, so a dirty step waits for the dirty steps feeding it and nothing else.
+    eval.Waits.assign(eval.Steps.size(), 0);
+    for (uint32_t s = 0; s < eval.Steps.size(); s++) {
+        if (!eval.Dirty[s])
+            continue;
+        const EvaluationStep& step = eval.Steps[s];
+        for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++)
+            eval.Waits[eval.Dependents[d]]++;
+    }
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> ready;   // Unwanted in the high bits.
+    for (uint32_t s = 0; s < eval.Steps.size(); s++)
+        if (eval.Dirty[s] && eval.Waits[s] == 0)
+            ready.push((uint64_t)!eval.Wanted[s] << 32 | s);
+
+    // At least one step per call, so any budget gets there.
+    eval.Keys.resize(1);
+    eval.Timings.assign(s_Session->Profiler.Enabled ? eval.Steps.size() : 0, -1.0);
+    while (!ready.empty()) {
+        if (eval.LastRun > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= seconds)
+            return false;
+        uint32_t s = (uint32_t)ready.top();
+        ready.pop();
+        const EvaluationStep& step = eval.Steps[s];
+        RunStep(eval, s_Session->s_Nodes, s, 0);
+        if (!eval.Timings.empty())
+            RecordProfile(step.Id, eval.Timings[s], eval.Values.data() + step.Outputs, nodes[step.Node].Outputs.size());
+        eval.Evaluated[s] = nodes[step.Node].PropertyGeneration;
+        eval.Dirty[s] = 0;
+        eval.LastRun++;
+        for (uint32_t d = step.Dependents; d < step.Dependents + step.DependentCount; d++)
+            if (--eval.Waits[eval.Dependents[d]] == 0)
+                ready.push((uint64_t)!eval.Wanted[eval.Dependents[d]] << 32 | eval.Dependents[d]);
+    }
+    return !eval.Cyclic;
+}
+
+Value* PinValue(ed::PinId id)
+{
+    Pin* pin = FindPin(id);
+    if (!pin || !CarriesValue(pin->Type))
+        return nullptr;
+
+    BuildSchedule();
+    auto& eval = s_Session->Evaluation;
+    auto slot = eval.PinSlots.find(id.Get());
+    return slot == eval.PinSlots.end() ? nullptr : &eval.Values[slot->second];
+}
+
+void SetInputValue(ed::PinId id, const Value& value)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& eval = s_Session->Evaluation;
+    eval.InputValues[id.Get()] = value;
+
+    // An unlinked input's slot is its own, so it takes the value now.  Anything else waits until it is unlinked.
+    BuildSchedule();
+    auto slot = eval.PinSlots.find(id.Get());
+    if (slot == eval.PinSlots.end() || slot->second < eval.FirstInputSlot)
+        return;
+    eval.Values[slot->second] = value;
+    if (const PinSlot* pin = FindPinSlot(id))
+        if (eval.StepOf[pin->Node] != UINT32_MAX)
+            eval.Dirty[eval.StepOf[pin->Node]] = 1;
+}
+
+void MarkNodeDirty(ed::NodeId id)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    Node* node = FindNode(id);
+    if (!node)
+        return;
+
+    BuildSchedule();
+    auto& eval = s_Session->Evaluation;
+    uint32_t step = eval.StepOf[node - s_Session->s_Nodes.data()];
+    if (step != UINT32_MAX)
+        eval.Dirty[step] = 1;
+}
+
+void MarkReadersDirty(size_t node)
+{
+    auto& eval = s_Session->Evaluation;
+    for (uint32_t r = eval.FirstReaders[node]; r < eval.FirstReaders[node + 1]; r++)
+        eval.Dirty[eval.Readers[r]] = 1;
+}
+
+} // inner namespace
+} // outer namespace
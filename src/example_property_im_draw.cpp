@@ -1,5 +1,15 @@
 #include <internal/example_property_im_draw.h>
-void im_draw_basic_widgets (attr_table& p) {
+
+// Property names are interned once, rather than turned into std::strings for every lookup, every frame.
+static const prop_key ButtonData    = prop_intern("buttonData");
+static const prop_key RadioData     = prop_intern("radioData");
+static const prop_key RepeaterData  = prop_intern("repeaterData");
+static const prop_key InputTextData = prop_intern("inputTextData");
+static const prop_key FloatData     = prop_intern("floatData");
+static const prop_key DragData      = prop_intern("dragData");
+static const prop_key DragData2     = prop_intern("dragData2");
+
+void im_draw_basic_widgets (Properties& p) {
 
     // Basic Widgets Demo  ==============================================================================================
     ImGui::Text("Basic Widget Demo");
@@ -7,19 +17,19 @@ void im_draw_basic_widgets (attr_table& p) {
     // Widget Demo from imgui_demo.cpp...
     // Normal Button
     if (ImGui::Button("Button")) {
-        p.pint["buttonData"]++;
+        p.pint[ButtonData]++;
     }
     ImGui::SameLine();
-    ImGui::Text("Times Clicked: %u", p.pint["buttonData"]);
+    ImGui::Text("Times Clicked: %u", p.pint[ButtonData]);
 
     // Checkbox - needs bool type
     // ImGui::Checkbox("checkbox", p.pint["checkData"]);
     
     // Radio buttons
     
-    ImGui::RadioButton("radio a", &p.pint["radioData"], 0); ImGui::SameLine();
-    ImGui::RadioButton("radio b", &p.pint["radioData"], 1); ImGui::SameLine();
-    ImGui::RadioButton("radio c", &p.pint["radioData"], 2);
+    ImGui::RadioButton("radio a", &p.pint[RadioData], 0); ImGui::SameLine();
+    ImGui::RadioButton("radio b", &p.pint[RadioData], 1); ImGui::SameLine();
+    ImGui::RadioButton("radio c", &p.pint[RadioData], 2);
     
 
     // Color buttons, demonstrate using PushID() to add unique identifier in the ID stack, and changing style.
@@ -44,26 +54,26 @@ void im_draw_basic_widgets (attr_table& p) {
     // Arrow buttons with Repeater
     float spacing = ImGui::GetStyle().ItemInnerSpacing.x;
     ImGui::PushButtonRepeat(true);
-    if (ImGui::ArrowButton("##left", ImGuiDir_Left)) { p.pint["repeaterData"]--; }
+    if (ImGui::ArrowButton("##left", ImGuiDir_Left)) { p.pint[RepeaterData]--; }
     ImGui::SameLine(0.0f, spacing);
-    if (ImGui::ArrowButton("##right", ImGuiDir_Right)) { p.pint["repeaterData"]++; }
+    if (ImGui::ArrowButton("##right", ImGuiDir_Right)) { p.pint[RepeaterData]++; }
     ImGui::PopButtonRepeat();
     ImGui::SameLine();
-    ImGui::Text("%d", p.pint["repeaterData"]);
+    ImGui::Text("%d", p.pint[RepeaterData]);
 
     // The input widgets also require you to manually disable the editor shortcuts so the view doesn't fly around.
     // (note that this is a per-frame setting, so it disables it for all text boxes.  I left it here so you could find it!)
     ax::NodeEditor::EnableShortcuts(ImGui::GetIO().WantTextInput);
     // The input widgets require some guidance on their widths, or else they're very large. (note matching pop at the end).
     ImGui::PushItemWidth(200);
-    ImGui::InputTextWithHint("input text (w/ hint)", "enter text here", &p.pstring["inputTextData"]);
+    ImGui::InputTextWithHint("input text (w/ hint)", "enter text here", &p.pstring[InputTextData]);
     
-    ImGui::InputFloat("input float", &p.pfloat["floatData"], 0.01f, 1.0f, "%.3f");
+    ImGui::InputFloat("input float", &p.pfloat[FloatData], 0.01f, 1.0f, "%.3f");
 
 
-    ImGui::DragFloat("drag float", &p.pfloat["dragData"], 0.005f);
+    ImGui::DragFloat("drag float", &p.pfloat[DragData], 0.005f);
 
-    ImGui::DragFloat("drag small float", &p.pfloat["dragData2"], 0.0001f, 0.0f, 0.0f, "%.06f ns");
+    ImGui::DragFloat("drag small float", &p.pfloat[DragData2], 0.0001f, 0.0f, 0.0f, "%.06f ns");
     
 
     ImGui::PopItemWidth();
@@ -0,0 +1,536 @@
+#include <internal/flat_table.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// C to Instance adaptor
+std::string Prop_Serialize(const flat_table& Prop_In, unsigned long& entries, const flat_table* Defaults)
+{
+    return Prop_In.serialize(entries, Defaults);
+}
+
+void Prop_Deserialize(flat_table& Prop_In, const std::string& serialized_table, bool Merge)
+{
+    return Prop_In.deseralize(serialized_table, Merge);
+}
+
+void Prop_SerializeBinary(const flat_table& Prop_In, prop_dictionary& dict, std::string& out, const flat_table* Defaults)
+{
+    Prop_In.encode(out, dict, Defaults);
+}
+
+bool Prop_DeserializeBinary(flat_table& Prop_In, const prop_dictionary& dict, const char* data, size_t size, bool Merge)
+{
+    return Prop_In.decode(data, size, dict, Merge);
+}
+
+void Prop_Diff(const flat_table& Before, const flat_table& After, std::vector<prop_key>& changed)
+{
+    After.diff(Before, changed);
+}
+
+bool Prop_Equal(const flat_table& A, const flat_table& B)
+{
+    return A.equals(B);
+}
+
+bool Prop_Covers(const flat_table& Prop_In, const flat_table& Defaults)
+{
+    return Prop_In.covers(Defaults);
+}
+
+void Prop_Track(flat_table& Prop_In, prop_write_log* Log)
+{
+    Prop_In.track(Log);
+}
+
+void Prop_LoggedChanges(const flat_table& Prop_In, const prop_write_log& Log, std::vector<prop_key>& changed)
+{
+    Prop_In.logged_changes(Log, changed);
+}
+
+
+uint32_t flat_table::hash(uint32_t key_hash, flat_type type)
+{
+    // Fold the type in and finish with a mix, since the low bits pick the slot.
+    uint32_t h = key_hash ^ ((uint32_t)type * 0x9E3779B9u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h;
+}
+
+// Index of the slot holding key/type, or of the empty slot where it would go.
+size_t flat_table::probe(const char* key, size_t length, flat_type type, uint32_t h) const
+{
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask; ; i = (i + 1) & mask) {
+        const flat_slot& slot = slots[i];
+        if (slot.type == flat_type::empty)
+            return i;
+        if (slot.hash == h && slot.type == type && slot.key.name->size() == length && memcmp(slot.key.name->data(), key, length) == 0)
+            return i;
+    }
+}
+
+size_t flat_table::probe(const prop_key& key, flat_type type, uint32_t h) const
+{
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask; ; i = (i + 1) & mask) {
+        const flat_slot& slot = slots[i];
+        if (slot.type == flat_type::empty || (slot.key.id == key.id && slot.type == type))
+            return i;
+    }
+}
+
+void flat_table::grow(void)
+{
+    std::vector<flat_slot> old;
+    old.swap(slots);
+    slots.resize(old.empty() ? 8 : old.size() * 2);
+
+    size_t mask = slots.size() - 1;
+    for (auto& slot : old) {
+        if (slot.type == flat_type::empty)
+            continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].type != flat_type::empty)
+            i = (i + 1) & mask;
+        slots[i] = std::move(slot);
+    }
+}
+
+flat_slot& flat_table::insert(const prop_key& key, flat_type type, uint32_t h)
+{
+    // Keep the table at most 3/4 full so probes stay short.
+    if ((used + 1) * 4 > slots.size() * 3)
+        grow();
+
+    flat_slot& slot = slots[probe(key, type, h)];
+    slot.hash = h;
+    slot.type = type;
+    slot.value.i = 0;
+    slot.key = key;
+    slot.str.clear();
+    slot.blob = prop_blob();
+    used++;
+    return slot;
+}
+
+// Where a slot keeps a value of its type.
+static void* SlotValue(flat_slot& slot)
+{
+    switch (slot.type) {
+        case flat_type::pstring: return &slot.str;
+        case flat_type::pint:    return &slot.value.i;
+        case flat_type::pfloat:  return &slot.value.f;
+        case flat_type::pbool:   return &slot.value.b;
+        case flat_type::pints:
+        case flat_type::pfloats:
+        case flat_type::pblob:   return &slot.blob;
+        default:                 return nullptr;
+    }
+}
+
+void flat_table::note(const prop_key& key, flat_type type, const void* current)
+{
+    if (log->everything || log->find(type, key))
+        return;
+    log->writes.emplace_back();
+    prop_write& w = log->writes.back();
+    w.type = type;
+    w.key = key;
+    w.save(current);
+}
+
+void* flat_table::value(const char* key, size_t length, flat_type type, bool create)
+{
+    uint32_t key_hash = prop_hash(key, length);
+    if (schema && type != flat_type::pstring)
+        if (const prop_schema_field* field = schema->find(key, length, key_hash, type)) {
+            void* field_value = block.data() + field->offset;
+            if (log)
+                note(field->key, type, field_value);
+            return field_value;
+        }
+
+    uint32_t h = hash(key_hash, type);
+    if (!slots.empty()) {
+        flat_slot& slot = slots[probe(key, length, type, h)];
+        if (slot.type != flat_type::empty) {
+            if (log)
+                note(slot.key, type, SlotValue(slot));
+            return SlotValue(slot);
+        }
+    }
+    if (!create)
+        return nullptr;
+
+    // Only new keys pay for interning.
+    prop_key interned = prop_intern(key, length);
+    if (log)
+        note(interned, type, nullptr);
+    return SlotValue(insert(interned, type, h));
+}
+
+void* flat_table::value(const prop_key& key, flat_type type, bool create)
+{
+    if (schema && type != flat_type::pstring)
+        if (const prop_schema_field* field = schema->find(key, type)) {
+            void* field_value = block.data() + field->offset;
+            if (log)
+                note(field->key, type, field_value);
+            return field_value;
+        }
+
+    uint32_t h = hash(key.hash, type);
+    if (!slots.empty()) {
+        flat_slot& slot = slots[probe(key, type, h)];
+        if (slot.type != flat_type::empty) {
+            if (log)
+                note(slot.key, type, SlotValue(slot));
+            return SlotValue(slot);
+        }
+    }
+    if (!create)
+        return nullptr;
+    if (log)
+        note(key, type, nullptr);
+    return SlotValue(insert(key, type, h));
+}
+
+const void* flat_table::value(const char* key, size_t length, flat_type type) const
+{
+    uint32_t key_hash = prop_hash(key, length);
+    if (schema && type != flat_type::pstring)
+        if (const prop_schema_field* field = schema->find(key, length, key_hash, type))
+            return block.data() + field->offset;
+
+    if (slots.empty())
+        return nullptr;
+    const flat_slot& slot = slots[probe(key, length, type, hash(key_hash, type))];
+    return slot.type == flat_type::empty ? nullptr : SlotValue(const_cast<flat_slot&>(slot));
+}
+
+const void* flat_table::value(const prop_key& key, flat_type type) const
+{
+    if (schema && type != flat_type::pstring)
+        if (const prop_schema_field* field = schema->find(key, type))
+            return block.data() + field->offset;
+
+    if (slots.empty())
+        return nullptr;
+    const flat_slot& slot = slots[probe(key, type, hash(key.hash, type))];
+    return slot.type == flat_type::empty ? nullptr : SlotValue(const_cast<flat_slot&>(slot));
+}
+
+bool flat_table::erase(const char* key, size_t length, flat_type type)
+{
+    if (slots.empty())
+        return false;
+    size_t mask = slots.size() - 1;
+    size_t hole = probe(key, length, type, hash(prop_hash(key, length), type));
+    if (slots[hole].type == flat_type::empty)
+        return false;
+    if (log)
+        note(slots[hole].key, type, SlotValue(slots[hole]));
+
+    // Backward shift deletion: pull later entries of the probe run into the hole, so there are no tombstones.
+    for (size_t i = (hole + 1) & mask; slots[i].type != flat_type::empty; i = (i + 1) & mask) {
+        size_t home = slots[i].hash & mask;
+        bool movable = hole <= i ? (home <= hole || home > i) : (home <= hole && home > i);
+        if (movable) {
+            slots[hole] = std::move(slots[i]);
+            hole = i;
+        }
+    }
+    slots[hole].type = flat_type::empty;
+    slots[hole].str.clear();
+    slots[hole].blob = prop_blob();
+    used--;
+    return true;
+}
+
+void flat_table::clear(void)
+{
+    if (log)
+        log->everything = true;
+    for (auto& slot : slots) {
+        slot.type = flat_type::empty;
+        slot.str.clear();
+        slot.blob = prop_blob();
+    }
+    used = 0;
+
+    if (!schema)
+        return;
+    block = schema->prototype;
+    size_t string_index = 0;
+    for (const auto& field : schema->fields)
+        if (field.type == flat_type::pstring)
+            *(std::string*)value(field.key, flat_type::pstring, true) = schema->strings[string_index++];
+}
+
+void flat_table::set_schema(std::shared_ptr<const prop_schema> layout)
+{
+    schema = std::move(layout);
+    block.clear();
+    clear();
+}
+
+void flat_table::logged_changes(const prop_write_log& write_log, std::vector<prop_key>& changed) const
+{
+    for (const prop_write& w : write_log.writes)
+        if (w.changed(value(w.key, w.type)))
+            changed.push_back(w.key);
+}
+
+void flat_table::sorted_entries(std::vector<entry>& order) const
+{
+    order.reserve(size());
+    for (const auto& slot : slots)
+        if (slot.type != flat_type::empty)
+            order.push_back({ slot.type, &slot.key, SlotValue(const_cast<flat_slot&>(slot)) });
+    if (schema)
+        for (const auto& field : schema->fields)
+            if (field.type != flat_type::pstring)
+                order.push_back({ field.type, &field.key, block.data() + field.offset });
+    std::sort(order.begin(), order.end(), [](const entry& a, const entry& b) {
+        return a.type != b.type ? a.type < b.type : *a.key->name < *b.key->name;
+    });
+}
+
+static bool SameValue(flat_type type, const void* a, const void* b)
+{
+    switch (type) {
+        case flat_type::pstring: return *(const std::string*)a == *(const std::string*)b;
+        case flat_type::pint:    return *(const int*)a == *(const int*)b;
+        case flat_type::pfloat:  return *(const float*)a == *(const float*)b;
+        case flat_type::pbool:   return *(const bool*)a == *(const bool*)b;
+        case flat_type::pints:
+        case flat_type::pfloats:
+        case flat_type::pblob:   return *(const prop_blob*)a == *(const prop_blob*)b;
+        default:                 return true;
+    }
+}
+
+template <typename F>
+void flat_table::each(F visit) const
+{
+    for (const auto& slot : slots)
+        if (slot.type != flat_type::empty)
+            visit(slot.type, slot.key, (const void*)SlotValue(const_cast<flat_slot&>(slot)));
+    if (schema)
+        for (const auto& field : schema->fields)
+            if (field.type != flat_type::pstring)
+                visit(field.type, field.key, (const void*)(block.data() + field.offset));
+}
+
+bool flat_table::equals(const flat_table& other) const
+{
+    if (size() != other.size())
+        return false;
+    bool same = true;
+    each([&](flat_type type, const prop_key& key, const void* mine) {
+        const void* theirs = same ? other.value(key, type) : nullptr;
+        same = theirs && SameValue(type, mine, theirs);
+    });
+    return same;
+}
+
+bool flat_table::covers(const flat_table& defaults) const
+{
+    bool found = true;
+    defaults.each([&](flat_type type, const prop_key& key, const void*) {
+        found = found && value(key, type) != nullptr;
+    });
+    return found;
+}
+
+void flat_table::diff(const flat_table& before, std::vector<prop_key>& changed) const
+{
+    // Slot order depends on insertion history, so compare the two tables in save order.
+    std::vector<entry> mine, theirs;
+    sorted_entries(mine);
+    before.sorted_entries(theirs);
+
+    auto order = [](const entry& a, const entry& b) {
+        return a.type != b.type ? a.type < b.type : *a.key->name < *b.key->name;
+    };
+    size_t m = 0, t = 0;
+    while (m < mine.size() || t < theirs.size()) {
+        if (m == mine.size() || (t < theirs.size() && order(theirs[t], mine[m]))) {
+            changed.push_back(*theirs[t++].key);
+        } else if (t == theirs.size() || order(mine[m], theirs[t])) {
+            changed.push_back(*mine[m++].key);
+        } else {
+            if (!SameValue(mine[m].type, mine[m].value, theirs[t].value))
+                changed.push_back(*mine[m].key);
+            m++;
+            t++;
+        }
+    }
+}
+
+// Drops the entries whose value is the same in "defaults".
+static void RemoveDefaults(std::vector<flat_table::entry>& order, const flat_table* defaults)
+{
+    if (!defaults)
+        return;
+    order.erase(std::remove_if(order.begin(), order.end(), [&](const flat_table::entry& e) {
+        const void* theirs = defaults->value(*e.key, e.type);
+        return theirs && SameValue(e.type, e.value, theirs);
+    }), order.end());
+}
+
+std::string flat_table::serialize(unsigned long& entries, const flat_table* defaults) const
+{
+    // Same order as attr_table, so both write identical files.
+    std::vector<entry> order;
+    sorted_entries(order);
+    RemoveDefaults(order, defaults);
+
+    std::string serialization;
+    entries = 0;
+    for (const entry& e : order) {
+        serialization.append(*e.key->name);
+        serialization.push_back('\n');
+        switch (e.type) {
+            case flat_type::pstring: serialization.append(*(const std::string*)e.value);              serialization.append("\ns\n"); break;
+            case flat_type::pint:    serialization.append(std::to_string(*(const int*)e.value));       serialization.append("\ni\n"); break;
+            case flat_type::pfloat:  serialization.append(prop_format_float(*(const float*)e.value));  serialization.append("\nf\n"); break;
+            case flat_type::pbool:   serialization.append(*(const bool*)e.value ? "1" : "0");         serialization.append("\nb\n"); break;
+            case flat_type::pints:
+            case flat_type::pfloats:
+            case flat_type::pblob: {
+                // Raw: the byte count, the type, then the bytes.
+                const prop_blob& blob = *(const prop_blob*)e.value;
+                serialization.append(std::to_string(blob.size()));
+                serialization.push_back('\n');
+                serialization.push_back(prop_text_letter(e.type));
+                serialization.push_back('\n');
+                serialization.append((const char*)blob.data(), blob.size());
+                serialization.push_back('\n');
+                break;
+            }
+            default: break;
+        }
+        entries++;
+    }
+    return serialization;
+}
+
+void flat_table::encode(std::string& out, prop_dictionary& dict, const flat_table* defaults) const
+{
+    // Sorted too, so the same properties always encode to the same bytes.
+    std::vector<entry> order;
+    sorted_entries(order);
+    RemoveDefaults(order, defaults);
+
+    prop_begin_binary(out, (uint32_t)order.size());
+    for (const entry& e : order)
+        prop_put_binary(out, dict, e.type, *e.key, e.value);
+}
+
+bool flat_table::decode(const char* data, size_t size, const prop_dictionary& dict, bool merge)
+{
+    if (!merge)
+        clear();
+    prop_binary_reader in(data, size, dict);
+    uint32_t entries;
+    if (!in.begin(entries))
+        return false;
+
+    while (slots.size() * 3 < (used + entries) * 4)
+        grow();
+
+    for (uint32_t i = 0; i < entries; i++) {
+        prop_type type;
+        const prop_key* key;
+        if (!in.next(type, key))
+            return false;
+
+        void* target = value(*key, type, true);
+        bool ok = false;
+        switch (type) {
+            case flat_type::pint:   ok = in.get(*(int*)target);   break;
+            case flat_type::pfloat: ok = in.get(*(float*)target); break;
+            case flat_type::pbool:  ok = in.get(*(bool*)target);  break;
+            case flat_type::pstring: {
+                const char* text;
+                size_t length;
+                ok = in.get(text, length);
+                if (ok)
+                    ((std::string*)target)->assign(text, length);
+                break;
+            }
+            case flat_type::pints:
+            case flat_type::pfloats:
+            case flat_type::pblob: {
+                const char* bytes;
+                size_t length;
+                ok = in.get(bytes, length);
+                if (ok)
+                    *(prop_blob*)target = prop_blob::from_bytes(bytes, length);
+                break;
+            }
+            default: break;
+        }
+        if (!ok)
+            return false;
+    }
+    return in.done();
+}
+
+void flat_table::deseralize(const std::string& serialized_table, bool merge) {
+    if (!merge)
+        clear(); // flat_table::clear();
+    if (serialized_table.empty())
+        return;
+
+    // Size the table once for the whole record.  Capped, because the raw bytes of arrays can hold newlines too.
+    size_t lines = (size_t)std::count(serialized_table.begin(), serialized_table.end(), '\n') + 1;
+    size_t wanted = used + std::min(lines / 3 + 1, (size_t)64);
+    while (slots.size() * 3 < wanted * 4)
+        grow();
+
+    const char* at = serialized_table.data();
+    const char* end = at + serialized_table.size();
+    auto next_line = [&](const char*& begin, size_t& length) {
+        const char* eol = (const char*)memchr(at, '\n', (size_t)(end - at));
+        begin = at;
+        length = (size_t)((eol ? eol : end) - at);
+        at = eol ? eol + 1 : end;
+    };
+
+    while (at < end) {
+        const char *key, *text_begin, *type;
+        size_t key_length, text_length, type_length;
+        next_line(key, key_length);
+        next_line(text_begin, text_length);
+        next_line(type, type_length);
+        if (type_length == 0)
+            continue;
+
+        // strtof/strtol need a terminated string; values are short.
+        std::string text(text_begin, text_length);
+        switch (type[0]) {
+            case 's' : *(std::string*)value(key, key_length, flat_type::pstring, true) = std::move(text);                     break;
+            case 'f' : *(float*)value(key, key_length, flat_type::pfloat, true) = std::strtof(text.c_str(), nullptr);          break;
+            case 'i' : *(int*)value(key, key_length, flat_type::pint, true) = (int)std::strtol(text.c_str(), nullptr, 10);     break;
+            case 'b' : *(bool*)value(key, key_length, flat_type::pbool, true) = std::strtol(text.c_str(), nullptr, 10) == 1;   break;
+            case 'I' :
+            case 'F' :
+            case 'x' : {
+                // Raw bytes follow the type line.  A damaged count takes what's left of the record.
+                size_t length = std::min((size_t)std::strtoul(text.c_str(), nullptr, 10), (size_t)(end - at));
+                *(prop_blob*)value(key, key_length, prop_text_type(type[0]), true) = prop_blob::from_bytes(at, length);
+                at += length;
+                if (at < end && *at == '\n')
+                    at++;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,232 @@
+#include <internal/flow.h>
+#include <internal/internal.h>
+
+using namespace plano::types;
+namespace ed = ax::NodeEditor;
+
+namespace plano {
+namespace internal {
+
+// Execute calls one flow may make in one tick before it counts as an endless loop and is ended.
+static const size_t s_FlowCallLimit = 1000000;
+
+// Flow output pin -> the Flow input pins it links to.  Only rebuilt when nodes or links changed.
+static void BuildFlowIndex(FlowState& flow)
+{
+    auto& eval = s_Session->Evaluation;
+    if (flow.Built == eval.Structure)
+        return;
+
+    auto& nodes = s_Session->s_Nodes;
+    flow.Next.clear();
+    for (auto& link : s_Session->s_Links) {
+        const PinSlot* start = FindPinSlot(link.StartPinID);
+        const PinSlot* end = FindPinSlot(link.EndPinID);
+        if (!start || !end || !start->Output || end->Output || nodes[start->Node].Outputs[start->Pin].Type != PinType::Flow)
+            continue;
+        flow.Next[link.StartPinID.Get()].push_back(link.EndPinID.Get());
+    }
+    flow.Built = eval.Structure;
+}
+
+static uint32_t NewRecord(FlowState& flow, const PinSlot& input)
+{
+    uint32_t r;
+    if (!flow.Free.empty()) {
+        r = flow.Free.back();
+        flow.Free.pop_back();
+    } else {
+        r = (uint32_t)flow.Records.size();
+        flow.Records.emplace_back();
+    }
+    FlowRecord& record = flow.Records[r];
+    record.Node = s_Session->s_Nodes[input.Node].ID.Get();
+    record.Run = Execution();
+    record.Run.Input = (int)input.Pin;
+    record.Live = true;
+    return r;
+}
+
+static void ReleaseRecord(FlowState& flow, uint32_t r)
+{
+    flow.Records[r].Live = false;
+    flow.Records[r].Run = Execution();   // Drops State.
+    flow.Free.push_back(r);
+}
+
+// Queues a new flow into every input the output links to.
+static void StartFlows(FlowState& flow, uintptr_t output)
+{
+    auto next = flow.Next.find(output);
+    if (next == flow.Next.end())
+        return;
+    for (uintptr_t input : next->second)
+        if (const PinSlot* slot = FindPinSlot(ed::PinId(input)))
+            flow.Ready.push_back(NewRecord(flow, *slot));
+}
+
+// The Flow output of a node with that index, 0 if it isn't one.
+static uintptr_t FlowOutput(const Node& node, int output)
+{
+    if (output < 0 || output >= (int)node.Outputs.size() || node.Outputs[output].Type != PinType::Flow)
+        return 0;
+    return node.Outputs[output].ID.Get();
+}
+
+// Runs one flow until it ends or suspends.
+static size_t Advance(FlowState& flow, uint32_t r)
+{
+    auto& eval = s_Session->Evaluation;
+    size_t calls = 0;
+    for (;;) {
+        Node* node = FindNode(ed::NodeId(flow.Records[r].Node));
+        const RegisteredType* type = node ? FindNodeType(node->Name) : nullptr;
+        if (!type || !type->Description.Execute || calls >= s_FlowCallLimit) {
+            ReleaseRecord(flow, r);
+            return calls;
+        }
+
+        // Inputs read what the steps computed, so those come first if an Execute changed what they read.
+        BuildSchedule();
+        BuildFlowIndex(flow);
+        if (flow.Stale) {
+            flow.Stale = false;
+            EvaluateGraph();
+        }
+        size_t n = node - s_Session->s_Nodes.data();
+        Execution& run = flow.Records[r].Run;
+        run.Now = flow.Now;
+        FlowAction action = type->Description.Execute(run, PeekProperties(*node),
+                                                      eval.Arguments.data() + eval.FirstInputs[n],
+                                                      eval.Values.data() + eval.FirstOutputs[n]);
+        calls++;
+        if (eval.FirstReaders[n] != eval.FirstReaders[n + 1]) {
+            MarkReadersDirty(n);
+            flow.Stale = true;
+        }
+
+        // Execute may have added or deleted nodes.
+        node = FindNode(ed::NodeId(flow.Records[r].Node));
+        int fork = flow.Records[r].Run.Fork;
+        flow.Records[r].Run.Fork = -1;
+        if (node && fork >= 0)
+            StartFlows(flow, FlowOutput(*node, fork));
+
+        switch (action.What) {
+            case FlowAction::Then: {
+                // The flow moves on to the first linked input; any other links get flows of their own.
+                auto next = node ? flow.Next.find(FlowOutput(*node, action.Output)) : flow.Next.end();
+                const PinSlot* input = next != flow.Next.end() ? FindPinSlot(ed::PinId(next->second.front())) : nullptr;
+                if (!input) {
+                    ReleaseRecord(flow, r);
+                    return calls;
+                }
+                for (size_t i = 1; i < next->second.size(); i++)
+                    if (const PinSlot* other = FindPinSlot(ed::PinId(next->second[i])))
+                        flow.Ready.push_back(NewRecord(flow, *other));
+                flow.Records[r].Node = s_Session->s_Nodes[input->Node].ID.Get();
+                flow.Records[r].Run = Execution();
+                flow.Records[r].Run.Input = (int)input->Pin;
+                continue;
+            }
+            case FlowAction::Delay:
+                flow.Timers.emplace(flow.Now + action.Seconds, r);
+                flow.Suspended++;
+                return calls;
+            case FlowAction::Wait:
+                flow.Waiting[action.Signal ? action.Signal : ""].push_back(r);
+                flow.Suspended++;
+                return calls;
+            case FlowAction::Yield:
+                flow.Later.push_back(r);
+                return calls;
+            case FlowAction::Finish:
+            default:
+                ReleaseRecord(flow, r);
+                return calls;
+        }
+    }
+}
+
+bool FireFlowOutput(ed::NodeId id, int output)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    Node* node = FindNode(id);
+    if (!node)
+        return false;
+    if (output < 0)
+        for (size_t o = 0; o < node->Outputs.size() && output < 0; o++)
+            if (node->Outputs[o].Type == PinType::Flow)
+                output = (int)o;
+
+    uintptr_t pin = FlowOutput(*node, output);
+    if (!pin)
+        return false;
+    auto& flow = s_Session->Flow;
+    BuildFlowIndex(flow);
+    StartFlows(flow, pin);
+    return true;
+}
+
+size_t SignalFlows(const char* signal)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& flow = s_Session->Flow;
+    auto waiting = flow.Waiting.find(signal ? signal : "");
+    if (waiting == flow.Waiting.end())
+        return 0;
+
+    // During a tick they wait for the next one, or two flows signalling each other would never let it end.
+    std::vector<uint32_t> woken;
+    woken.swap(waiting->second);
+    flow.Waiting.erase(waiting);
+    for (uint32_t r : woken)
+        (flow.Running ? flow.Later : flow.Ready).push_back(r);
+    flow.Suspended -= woken.size();
+    return woken.size();
+}
+
+size_t TickFlows(double now)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& flow = s_Session->Flow;
+    if (flow.Running)
+        return 0;   // Called from an Execute.
+
+    flow.Running = true;
+    flow.Now = now;
+    for (uint32_t r : flow.Later)
+        flow.Ready.push_back(r);
+    flow.Later.clear();
+    while (!flow.Timers.empty() && flow.Timers.top().first <= now) {
+        flow.Ready.push_back(flow.Timers.top().second);
+        flow.Timers.pop();
+        flow.Suspended--;
+    }
+
+    // Flows started during the tick (forks, extra links) run in it too; woken ones wait for the next.
+    size_t calls = 0;
+    while (!flow.Ready.empty()) {
+        uint32_t r = flow.Ready.front();
+        flow.Ready.pop_front();
+        calls += Advance(flow, r);
+    }
+    flow.Running = false;
+    return calls;
+}
+
+void StopFlows()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& flow = s_Session->Flow;
+    flow.Records.clear();
+    flow.Free.clear();
+    flow.Ready.clear();
+    flow.Later.clear();
+    flow.Timers = decltype(flow.Timers)();
+    flow.Waiting.clear();
+    flow.Suspended = 0;
+}
+
+} // inner namespace
+} // outer namespace
@@ -32,6 +32,9 @@ void Frame(void)
 
     ed::SetCurrentEditor(s_Session->m_Editor);
 
+    // Results of EvaluateAsync go in before anything draws, so the whole frame sees the same values.
+    PublishAsyncEvaluation();
+
     //auto& style = ImGui::GetStyle();
 
 # if 0
@@ -210,9 +213,9 @@ void Frame(void)
         Node* node = nullptr;
 
         // Populate the context right click menu with all the nodes in the registry.
-        for(auto nodos: s_Session->NodeRegistry){
-            if (ImGui::MenuItem(nodos.first.c_str())){
-                node = NewRegistryNode(nodos.first);
+        for(const RegisteredType* nodos: s_Session->Registry->SortedByName()){
+            if (ImGui::MenuItem(nodos->Description.Type.c_str())){
+                node = NewRegistryNode(nodos->Description.Type);
                 s_Session->IsProjectDirty = true;
             }
         }
@@ -242,6 +245,8 @@ void Frame(void)
 
                         s_Session->s_Links.emplace_back(Link(GetNextId(), startPin->ID, endPin->ID));
                         s_Session->s_Links.back().Color = GetIconColor(startPin->Type);
+                        StructureChanged();
+                        JournalLinkCreated(s_Session->s_Links.back());
 
                         break;
                     }
@@ -327,6 +332,21 @@ void Frame(void)
     auto editorMin = ImGui::GetItemRectMin();
     auto editorMax = ImGui::GetItemRectMax();
 
+    // Nodes on screen, which EvaluateSlice runs first.
+    {
+        auto canvasMin = ed::ScreenToCanvas(editorMin);
+        auto canvasMax = ed::ScreenToCanvas(editorMax);
+        auto& visible = s_Session->Evaluation.Visible;
+        visible.clear();
+        for (auto& node : s_Session->s_Nodes)
+        {
+            auto p0 = ed::GetNodePosition(node.ID);
+            auto p1 = p0 + ed::GetNodeSize(node.ID);
+            if (p1.x >= canvasMin.x && p1.y >= canvasMin.y && p0.x <= canvasMax.x && p0.y <= canvasMax.y)
+                visible.push_back(node.ID.Get());
+        }
+    }
+
     if (s_Session->m_ShowOrdinals)
     {
         int nodeCount = ed::GetNodeCount();
@@ -364,6 +384,57 @@ void Frame(void)
         drawList->PopClipRect();
     }
 
+    if (s_Session->m_ShowProfile)
+    {
+        int nodeCount = ed::GetNodeCount();
+        std::vector<ed::NodeId> orderedNodeIds;
+        orderedNodeIds.resize(static_cast<size_t>(nodeCount));
+        ed::GetOrderedNodeIds(orderedNodeIds.data(), nodeCount);
+
+        // Heat is relative to the slowest node drawn, so the culprit is red whatever the scale.
+        double slowest = 0.0;
+        for (auto& nodeId : orderedNodeIds)
+            if (const NodeProfile* profile = FindProfile(nodeId.Get()))
+                slowest = std::max(slowest, profile->Average);
+
+        auto drawList = ImGui::GetWindowDrawList();
+        drawList->PushClipRect(editorMin, editorMax);
+
+        for (auto& nodeId : orderedNodeIds)
+        {
+            const NodeProfile* profile = FindProfile(nodeId.Get());
+            if (!profile)
+                continue;
+
+            auto p0 = ed::GetNodePosition(nodeId);
+            auto p1 = p0 + ed::GetNodeSize(nodeId);
+            p0 = ed::CanvasToScreen(p0);
+            p1 = ed::CanvasToScreen(p1);
+
+            float heat = slowest > 0.0 ? (float)(profile->Average / slowest) : 0.0f;
+            ImU32 tint = IM_COL32((int)(255 * heat), (int)(255 * (1.0f - heat)), 0, 70);
+            drawList->AddRectFilled(p0, p1, tint, 3.0f, ImDrawFlags_RoundCornersAll);
+
+            ImGuiTextBuffer builder;
+            builder.appendf("%.3f ms", profile->Average * 1000.0);
+
+            auto textSize = ImGui::CalcTextSize(builder.c_str());
+            auto padding = ImVec2(2.0f, 2.0f);
+            auto widgetSize = textSize + padding * 2;
+
+            auto widgetPosition = ImVec2(p1.x - widgetSize.x, p1.y);
+
+            drawList->AddRectFilled(widgetPosition, widgetPosition + widgetSize, IM_COL32(80, 80, 80, 190), 3.0f, ImDrawFlags_RoundCornersAll);
+            drawList->AddRect(widgetPosition, widgetPosition + widgetSize, tint | IM_COL32(0, 0, 0, 255), 3.0f, ImDrawFlags_RoundCornersAll);
+            drawList->AddText(widgetPosition + padding, IM_COL32(255, 255, 255, 255), builder.c_str());
+        }
+
+        drawList->PopClipRect();
+    }
+
+    // Publish the nodes whose properties changed this frame.
+    EndTrackingFrame();
+
 
     //ImGui::ShowTestWindow();
     //ImGui::ShowMetricsWindow();
@@ -7,7 +7,8 @@ namespace ed = ax::NodeEditor;
 namespace plano {
 namespace internal {
 
-types::ContextData* s_Session;
+thread_local types::ContextData* s_Session = nullptr;
+std::atomic<int> context_id(0);
 
 int GetNextId() {
     return s_Session->s_NextId++;
@@ -95,14 +96,52 @@ ed::NodeId GetNextLinkId()
 }
 
 
+void InvalidateIdIndex()
+{
+    s_Session->IdIndexValid = false;
+    StructureChanged();
+}
+
+static void RebuildIdIndex()
+{
+    auto& nodes = s_Session->s_Nodes;
+    s_Session->NodeIndex.clear();
+    s_Session->PinIndex.clear();
+    for (auto& type : s_Session->TypeIndex)
+        type.second.clear();
+    for (size_t n = 0; n < nodes.size(); n++)
+    {
+        s_Session->NodeIndex[nodes[n].ID.Get()] = n;
+        s_Session->TypeIndex[nodes[n].Name].push_back(n);
+        for (size_t p = 0; p < nodes[n].Inputs.size(); p++)
+            s_Session->PinIndex[nodes[n].Inputs[p].ID.Get()] = PinSlot{ n, false, p };
+        for (size_t p = 0; p < nodes[n].Outputs.size(); p++)
+            s_Session->PinIndex[nodes[n].Outputs[p].ID.Get()] = PinSlot{ n, true, p };
+    }
+    s_Session->IdIndexValid = true;
+}
+
 Node* FindNode(ed::NodeId id)
 {
     assert(s_Session != nullptr); // you didn't call CreateContext();
-    for (auto& node : s_Session->s_Nodes)
-        if (node.ID == id)
-            return &node;
+    if (!s_Session->IdIndexValid)
+        RebuildIdIndex();
 
-    return nullptr;
+    auto it = s_Session->NodeIndex.find(id.Get());
+    if (it == s_Session->NodeIndex.end())
+        return nullptr;
+    return &s_Session->s_Nodes[it->second];
+}
+
+const std::vector<size_t>& NodesOfType(const std::string& NodeType)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    if (!s_Session->IdIndexValid)
+        RebuildIdIndex();
+
+    static const std::vector<size_t> none;
+    auto it = s_Session->TypeIndex.find(NodeType);
+    return it == s_Session->TypeIndex.end() ? none : it->second;
 }
 
 Link* FindLink(ed::LinkId id)
@@ -121,19 +160,25 @@ Pin* FindPin(ed::PinId id)
         return nullptr;
     
     assert(s_Session != nullptr); // you didn't call CreateContext();
-    
-    for (auto& node : s_Session->s_Nodes)
-    {
-        for (auto& pin : node.Inputs)
-            if (pin.ID == id)
-                return &pin;
+    if (!s_Session->IdIndexValid)
+        RebuildIdIndex();
 
-        for (auto& pin : node.Outputs)
-            if (pin.ID == id)
-                return &pin;
-    }
+    auto it = s_Session->PinIndex.find(id.Get());
+    if (it == s_Session->PinIndex.end())
+        return nullptr;
 
-    return nullptr;
+    auto& node = s_Session->s_Nodes[it->second.Node];
+    return it->second.Output ? &node.Outputs[it->second.Pin] : &node.Inputs[it->second.Pin];
+}
+
+const PinSlot* FindPinSlot(ed::PinId id)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    if (!s_Session->IdIndexValid)
+        RebuildIdIndex();
+
+    auto it = s_Session->PinIndex.find(id.Get());
+    return it == s_Session->PinIndex.end() ? nullptr : &it->second;
 }
 
 bool IsPinLinked(ed::PinId id)
@@ -150,7 +195,109 @@ bool IsPinLinked(ed::PinId id)
     return false;
 }
 
+void EraseLink(ed::LinkId id)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+
+    auto it = std::find_if(s_Session->s_Links.begin(), s_Session->s_Links.end(), [id](auto& link) { return link.ID == id; });
+    if (it == s_Session->s_Links.end())
+        return;
+
+    s_Session->s_Links.erase(it);
+    StructureChanged();
+    JournalLinkDeleted(id);
+}
+
+// Links refer to nodes's pins, so erasing a node also has to clean up the links that
+// referred to pins that were destroyed with it.  This incurs an expensive search.
+void EraseNode(ed::NodeId id)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+
+    auto it = std::find_if(s_Session->s_Nodes.begin(), s_Session->s_Nodes.end(), [id](auto& node) { return node.ID == id; });
+    if (it == s_Session->s_Nodes.end())
+        return;
+
+    // First, we have to record a node's pin IDs before destroying the node and its pins.
+    std::vector<ed::PinId> pin_ids;
+    for (auto& inp : it->Inputs)
+        pin_ids.push_back(inp.ID);
+    for (auto& outp : it->Outputs)
+        pin_ids.push_back(outp.ID);
+
+    // Now that we know what pin IDs the node had, we can actually destroy it now.
+    s_Session->s_Nodes.erase(it);
+    InvalidateIdIndex();
+    JournalNodeDeleted(id);
+
+    // erase() shifted the nodes after it, so their pins point at the wrong node now.
+    BuildNodes();
+
+    // We have to destroy link objects that were connected to this dead node.
+    // you do this by asking all the links if they're connected to the dead pin ids.
+    // Replaying the node deletion removes them again, so they don't get their own journal records.
+    auto& links = s_Session->s_Links;
+    links.erase(std::remove_if(links.begin(), links.end(), [&pin_ids](const Link& link) {
+        return std::find(pin_ids.begin(), pin_ids.end(), link.StartPinID) != pin_ids.end()
+            || std::find(pin_ids.begin(), pin_ids.end(), link.EndPinID) != pin_ids.end();
+    }), links.end());
+}
+
+Properties& GetProperties(Node& node)
+{
+    if (!node.PropertiesLoaded)
+    {
+        ParsePropertiesRecord(node, node.PropertySpan.data(), node.PropertySpan.size(), node.PropertySpanBinary, node.PropertySpanDelta);
+        node.PropertySpan.clear();
+        node.PropertySpanBinary = false;
+        node.PropertySpanDelta = false;
+        node.PropertySpan.shrink_to_fit();
+        node.PropertySpanEntries = 0;
+        node.PropertiesLoaded = true;
+    }
+    return node.Properties;
+}
 
+bool SharesDefaultProperties(const Node& node)
+{
+    return !node.PropertiesLoaded && node.PropertySpanDelta && node.PropertySpan.empty() && node.PropertyDefaults;
+}
+
+const Properties& PeekProperties(Node& node)
+{
+    return SharesDefaultProperties(node) ? *node.PropertyDefaults : GetProperties(node);
+}
+
+void ShareDefaultProperties(Node& node)
+{
+    node.Properties = Properties();
+    node.PropertySpan.clear();
+    node.PropertySpanEntries = 0;
+    node.PropertySpanBinary = false;
+    node.PropertySpanDelta = true;
+    node.PropertiesLoaded = false;
+}
+
+bool ParsePropertiesRecord(Node& node, const char* data, size_t size, bool binary, bool delta)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+
+    // A delta is read over a copy of the defaults.
+    bool merge = delta && node.PropertyDefaults;
+    if (merge) {
+        node.Properties = *node.PropertyDefaults;
+    } else if (!node.Properties.get_schema()) {
+        const RegisteredType* type = FindNodeType(node.Name);
+        if (type && type->Schema)
+            node.Properties.set_schema(type->Schema);
+    }
+
+    if (binary)
+        return Prop_DeserializeBinary(node.Properties, s_Session->PropertyKeys, data, size, merge);
+    if (size > 0 || !merge)
+        Prop_Deserialize(node.Properties, std::string(data, size), merge);
+    return true;
+}
 
 
 using ax::Drawing::IconType;
@@ -182,8 +329,13 @@ bool static_config_save_settings(const char* data, size_t size, ax::NodeEditor::
     
     assert(s_Session != nullptr); // you didn't call CreateContext();
     
-    s_Session->s_BlueprintData.reserve(size); //maybe not needed
-    s_Session->s_BlueprintData.assign(data);
+    // The backend saves its settings whenever anything is dirty, even if the JSON comes out the same.
+    auto& settings = s_Session->s_BlueprintData;
+    if (settings.size() != size || memcmp(settings.data(), data, size) != 0)
+    {
+        settings.assign(data, size);
+        JournalSettingsChanged();
+    }
 
     // Report project dirt for interactions we don't handle 
     if ((uint32_t)ax::NodeEditor::SaveReasonFlags::Position & (uint32_t)reason)
@@ -207,12 +359,17 @@ size_t static_config_load_settings(char* data, void* userPointer)
 size_t static_config_load_node_settings(ax::NodeEditor::NodeId nodeId, char* data, void* userPointer)
 {
      auto node = FindNode(nodeId);
-     if (!node)
+     if (!node || !node->State.HasLocation)
          return 0;
 
+     // The backend asks twice (once for the size, then for the data), so the JSON is built once and kept
+     // until the state changes again.
+     if (node->StateCache.empty())
+         node->StateCache = FormatNodeState(node->State);
+
      if (data != nullptr)
-         memcpy(data, node->State.data(), node->State.size());
-     return node->State.size();
+         memcpy(data, node->StateCache.data(), node->StateCache.size());
+     return node->StateCache.size();
 };
 
 
@@ -222,7 +379,11 @@ bool static_config_save_node_settings(ax::NodeEditor::NodeId nodeId, const char*
     if (!node)
         return false;
 
-    node->State.assign(data, size);
+    // Translate to the typed state right here; nothing else in plano handles the backend's JSON.
+    if (!ParseNodeState(data, size, node->State))
+        return false;
+    node->StateCache.clear();
+    JournalNodeStateChanged(nodeId);
 
     // Report project dirt for interactions we don't handle 
     if ((uint32_t)ax::NodeEditor::SaveReasonFlags::Position & (uint32_t)reason)
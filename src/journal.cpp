@@ -0,0 +1,207 @@
+#include <internal/journal.h>
+#include <internal/internal.h>
+#include <internal/serialization.h>
+
+#include <cstdio>
+
+using namespace plano::types;
+namespace ed = ax::NodeEditor;
+
+namespace plano {
+namespace internal {
+
+static bool IsRecording()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    return s_Session->Journal.Enabled && !s_Session->Journal.Replaying;
+}
+
+// State records are a single line: a field mask, then location, size and group size.
+static std::string FormatStateRecord(const NodeState& state)
+{
+    char buf[160];
+    int mask = (state.HasLocation ? 1 : 0) | (state.HasSize ? 2 : 0) | (state.HasGroupSize ? 4 : 0);
+    snprintf(buf, sizeof(buf), "%d %.9g %.9g %.9g %.9g %.9g %.9g", mask,
+        state.Location.x, state.Location.y, state.Size.x, state.Size.y, state.GroupSize.x, state.GroupSize.y);
+    return buf;
+}
+
+static bool ParseStateRecord(const std::string& line, NodeState& state)
+{
+    int mask;
+    NodeState parsed;
+    if (sscanf(line.c_str(), "%d %f %f %f %f %f %f", &mask,
+        &parsed.Location.x, &parsed.Location.y, &parsed.Size.x, &parsed.Size.y, &parsed.GroupSize.x, &parsed.GroupSize.y) != 7)
+        return false;
+
+    parsed.HasLocation  = (mask & 1) != 0;
+    parsed.HasSize      = (mask & 2) != 0;
+    parsed.HasGroupSize = (mask & 4) != 0;
+    state = parsed;
+    return true;
+}
+
+void JournalNodeCreated(const Node& node)
+{
+    if (!IsRecording())
+        return;
+
+    auto& pending = s_Session->Journal.Pending;
+    pending.append("N+\n");
+    WriteNodeRecord(pending, node);
+}
+
+void JournalNodeDeleted(ed::NodeId id)
+{
+    if (!IsRecording())
+        return;
+
+    auto& journal = s_Session->Journal;
+    journal.Pending.append("N-\n" + std::to_string(id.Get()) + "\n");
+
+    // Nothing coalesced for a dead node needs writing anymore.
+    journal.DirtyStates.erase((int)id.Get());
+    journal.DirtyProperties.erase((int)id.Get());
+}
+
+void JournalLinkCreated(const Link& link)
+{
+    if (!IsRecording())
+        return;
+
+    auto& pending = s_Session->Journal.Pending;
+    pending.append("L+\n");
+    WriteLinkRecord(pending, link);
+}
+
+void JournalLinkDeleted(ed::LinkId id)
+{
+    if (!IsRecording())
+        return;
+
+    s_Session->Journal.Pending.append("L-\n" + std::to_string(id.Get()) + "\n");
+}
+
+void JournalNodeStateChanged(ed::NodeId id)
+{
+    if (!IsRecording())
+        return;
+
+    s_Session->Journal.DirtyStates.insert((int)id.Get());
+}
+
+void JournalNodePropertiesChanged(ed::NodeId id)
+{
+    if (!IsRecording())
+        return;
+
+    s_Session->Journal.DirtyProperties.insert((int)id.Get());
+}
+
+void JournalSettingsChanged()
+{
+    if (!IsRecording())
+        return;
+
+    s_Session->Journal.DirtySettings = true;
+}
+
+std::string DrainJournal()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& journal = s_Session->Journal;
+
+    std::string records;
+    records.swap(journal.Pending);
+
+    // Coalesced records go last: every node they mention is alive, so its N+ record (if any) is already above.
+    for (int id : journal.DirtyStates)
+    {
+        auto node = FindNode(id);
+        if (!node)
+            continue;
+        records.append("S\n");
+        WriteLine(records, (unsigned long long)id);
+        WriteLine(records, FormatStateRecord(node->State));
+    }
+
+    for (int id : journal.DirtyProperties)
+    {
+        auto node = FindNode(id);
+        if (!node)
+            continue;
+        records.append("P\n");
+        WriteLine(records, (unsigned long long)id);
+        WritePropertiesRecord(records, *node);
+    }
+
+    if (journal.DirtySettings) {
+        records.append("C\n");
+        WriteLine(records, s_Session->s_BlueprintData);
+    }
+
+    journal.DirtyStates.clear();
+    journal.DirtyProperties.clear();
+    journal.DirtySettings = false;
+
+    journal.BytesSinceSnapshot += records.size();
+    return records;
+}
+
+void ResetJournal()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& journal = s_Session->Journal;
+
+    journal.Pending.clear();
+    journal.DirtyStates.clear();
+    journal.DirtyProperties.clear();
+    journal.DirtySettings = false;
+    journal.BytesSinceSnapshot = 0;
+}
+
+bool ReplayJournal(LineReader& in)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    s_Session->Journal.Replaying = true;
+
+    bool ok = true;
+    std::string tag, line;
+    long id;
+    while (ok && in.ReadLine(tag))
+    {
+        if (!tag.empty() && tag.back() == '\r')
+            tag.pop_back();
+
+        if (tag == "N+") {
+            ok = ReadNodeRecord(in);
+            BuildNodes(); // s_Nodes may have reallocated, so every pin needs its node pointer again.
+        } else if (tag == "N-") {
+            ok = in.ReadInt(id);
+            if (ok)
+                EraseNode((int)id);
+        } else if (tag == "L+") {
+            ok = ReadLinkRecord(in);
+        } else if (tag == "L-") {
+            ok = in.ReadInt(id);
+            if (ok)
+                EraseLink((int)id);
+        } else if (tag == "S") {
+            ok = in.ReadInt(id) && in.ReadLine(line);
+            auto node = ok ? FindNode((int)id) : nullptr;
+            if (node && ParseStateRecord(line, node->State))
+                node->StateCache.clear();
+        } else if (tag == "P") {
+            ok = in.ReadInt(id) && ReadPropertiesRecord(in, FindNode((int)id));
+        } else if (tag == "C") {
+            ok = in.ReadLine(s_Session->s_BlueprintData);
+        }
+        // Anything else is a blank line or a record from a newer version; skip it.
+    }
+
+    s_Session->Journal.Replaying = false;
+    return ok;
+}
+
+} // inner namespace
+} // outer namespace
@@ -0,0 +1,105 @@
+#include <internal/memo_cache.h>
+
+using namespace plano::types;
+
+namespace plano {
+namespace internal {
+
+static size_t ValueBytes(const Value& value)
+{
+    return sizeof(Value) + (value.String.capacity() > 15 ? value.String.capacity() : 0);
+}
+
+bool MemoCache::Find(uint64_t hash, const std::string& key, Value* outputs, size_t count)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    auto found = Index.find(hash);
+    if (found == Index.end() || found->second->Key != key || found->second->Outputs.size() != count) {
+        Counters.Misses++;
+        return false;
+    }
+
+    Entries.splice(Entries.begin(), Entries, found->second);
+    for (size_t i = 0; i < count; i++)
+        outputs[i] = found->second->Outputs[i];
+    Counters.Hits++;
+    return true;
+}
+
+void MemoCache::Insert(uint64_t hash, const std::string& key, const Value* const* inputs, size_t input_count,
+                       const Value* outputs, size_t count)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    if (Limit == 0)
+        return;
+
+    auto found = Index.find(hash);
+    if (found != Index.end()) {
+        Used -= found->second->Bytes;
+        Entries.erase(found->second);
+        Index.erase(found);
+    }
+
+    Entry entry { hash, key, std::vector<Value>(outputs, outputs + count), sizeof(Entry) + key.capacity() };
+    for (const auto& value : entry.Outputs)
+        entry.Bytes += ValueBytes(value);
+    for (size_t i = 0; i < input_count; i++)
+        if (inputs[i]->Type == PinType::Object) {
+            entry.Inputs.push_back(inputs[i]->Object);
+            entry.Bytes += sizeof(std::shared_ptr<void>);
+        }
+    if (entry.Bytes > Limit)
+        return;   // Would evict everything and still not fit.
+
+    Used += entry.Bytes;
+    Entries.push_front(std::move(entry));
+    Index[hash] = Entries.begin();
+    Evict(Limit);
+}
+
+void MemoCache::Evict(size_t limit)
+{
+    while (Used > limit && !Entries.empty()) {
+        Used -= Entries.back().Bytes;
+        Index.erase(Entries.back().Hash);
+        Entries.pop_back();
+        Counters.Evictions++;
+    }
+}
+
+void MemoCache::SetCapacity(size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    Limit = bytes;
+    Evict(Limit);
+}
+
+void MemoCache::Clear()
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    Entries.clear();
+    Index.clear();
+    Used = 0;
+}
+
+MemoCache::Stats MemoCache::GetStats()
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    Stats current = Counters;
+    current.Entries = Entries.size();
+    current.Bytes = Used;
+    return current;
+}
+
+uint64_t MemoCache::Hash(const std::string& key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // inner namespace
+} // outer namespace
@@ -1,36 +1,154 @@
 #include <internal/internal.h> // This brings in types and api as well.
                                    // also critically brings in s_Session, which these functions manipulate.
+#include <algorithm>
+#include <cstring>
+
 using namespace plano::types;
 using namespace plano::api;
 
 namespace plano {
+namespace types {
+
+const internal::RegisteredType* NodeRegistry::Find(const char* name, size_t length) const
+{
+    if (!Slots.empty()) {
+        uint32_t hash = prop_hash(name, length);
+        size_t mask = Slots.size() - 1;
+        for (size_t i = hash & mask; Slots[i] != 0; i = (i + 1) & mask) {
+            const internal::RegisteredType& type = Types[Slots[i] - 1];
+            if (type.Name.hash == hash && type.Name.name->size() == length && memcmp(type.Name.name->data(), name, length) == 0)
+                return &type;
+        }
+    }
+    return Base ? Base->Find(name, length) : nullptr;
+}
+
+const internal::RegisteredType& NodeRegistry::Add(NodeDescription description)
+{
+    assert(!Frozen); // A frozen registry may be shared; register into the context instead.
+    assert(Find(description.Type) == nullptr); // you can't register 2 nodes with the same name.
+
+    Types.emplace_back();
+    internal::RegisteredType& type = Types.back();
+    type.Name = prop_intern(description.Type);
+
+    // Lay the schema out once; every node of this type shares it.
+    if (!description.Schema.empty()) {
+        auto schema = std::make_shared<prop_schema>();
+        for (const auto& field : description.Schema) {
+            prop_key key = prop_intern(field.Name);
+            switch (field.DataType) {
+                case PinType::Int:    schema->add(key, prop_type::pint, &field.DefaultInt);       break;
+                case PinType::Float:  schema->add(key, prop_type::pfloat, &field.DefaultFloat);   break;
+                case PinType::Bool:   schema->add(key, prop_type::pbool, &field.DefaultBool);     break;
+                case PinType::String: schema->add(key, prop_type::pstring, &field.DefaultString); break;
+                default: assert(false); // Properties are Int, Float, Bool or String.
+            }
+        }
+        type.Schema = schema;
+    }
+
+    // Build the defaults once.  Nodes of this type share them until they're written to.
+    auto defaults = std::make_shared<Properties>();
+    if (type.Schema)
+        defaults->set_schema(type.Schema);
+    if (description.InitializeDefaultProperties) {
+        prop_blob_store* previous = prop_blob_store::current();
+        prop_blob_store::set_current(&Blobs);
+        description.InitializeDefaultProperties(*defaults);
+        prop_blob_store::set_current(previous);
+    }
+    type.Defaults = defaults;
+    type.Description = std::move(description);
+
+    // Index it.  The table grows at half full, so probes stay short and always reach an empty slot.
+    uint32_t index = (uint32_t)Types.size() - 1;
+    if (Types.size() * 2 > Slots.size()) {
+        Slots.assign(std::max<size_t>(16, Slots.size() * 2), 0);
+        for (uint32_t t = 0; t < Types.size(); t++) {
+            size_t mask = Slots.size() - 1;
+            size_t i = Types[t].Name.hash & mask;
+            while (Slots[i] != 0)
+                i = (i + 1) & mask;
+            Slots[i] = t + 1;
+        }
+    } else {
+        size_t mask = Slots.size() - 1;
+        size_t i = type.Name.hash & mask;
+        while (Slots[i] != 0)
+            i = (i + 1) & mask;
+        Slots[i] = index + 1;
+    }
+    auto by_name = [&](uint32_t a, uint32_t b) { return Types[a].Description.Type < Types[b].Description.Type; };
+    ByName.insert(std::upper_bound(ByName.begin(), ByName.end(), index, by_name), index);
+    return type;
+}
+
+size_t NodeRegistry::Count() const
+{
+    return Types.size() + (Base ? Base->Count() : 0);
+}
+
+std::vector<const internal::RegisteredType*> NodeRegistry::SortedByName() const
+{
+    std::vector<const internal::RegisteredType*> own;
+    own.reserve(ByName.size());
+    for (uint32_t t : ByName)
+        own.push_back(&Types[t]);
+    if (!Base)
+        return own;
+
+    std::vector<const internal::RegisteredType*> base = Base->SortedByName();
+    std::vector<const internal::RegisteredType*> all(base.size() + own.size());
+    std::merge(base.begin(), base.end(), own.begin(), own.end(), all.begin(),
+               [](const internal::RegisteredType* a, const internal::RegisteredType* b) {
+                   return a->Description.Type < b->Description.Type;
+               });
+    return all;
+}
+
+} // types namespace
+
 namespace internal {
 
+const RegisteredType* FindNodeType(const std::string& NodeType)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    return s_Session->Registry->Find(NodeType);
+}
+
 // This spawns a fresh node using the node definitions loaded into the registry.
-// The properties of the node are intialized with defaults from the definition.
+// The properties of the node are the defaults from the definition, shared until first written.
 Node* NewRegistryNode(const std::string& NodeName) {
 
     assert(s_Session != nullptr); // You didn't call CreateContext();
     
     // Standard node spawner behavior, only we construct the objects
     // using the registry data.
-    // NodeRegistry is a map, so we need the value.
-    NodeDescription Desc = s_Session->NodeRegistry[NodeName];
+    const RegisteredType* Type = FindNodeType(NodeName);
+    assert(Type != nullptr); // The node type must be registered.
+    const NodeDescription& Desc = Type->Description;
 
     // Create node object and pass the type name & color
     s_Session->s_Nodes.emplace_back(GetNextId(), Desc.Type.c_str(),Desc.Color);
+    InvalidateIdIndex();
 
     // Handle creating the pins
-    for(PinDescription p : Desc.Inputs)
+    for(const PinDescription& p : Desc.Inputs)
         s_Session->s_Nodes.back().Inputs.emplace_back(GetNextId(), p.Label.c_str(), p.DataType);
-    for(PinDescription p : Desc.Outputs)
+    for(const PinDescription& p : Desc.Outputs)
         s_Session->s_Nodes.back().Outputs.emplace_back(GetNextId(), p.Label.c_str(), p.DataType);
 
-    Desc.InitializeDefaultProperties(s_Session->s_Nodes.back().Properties);
+    // The node reads the type's defaults until something writes to its properties.
+    s_Session->s_Nodes.back().PropertyDefaults = Type->Defaults;
+    ShareDefaultProperties(s_Session->s_Nodes.back());
+    StampNewNode(s_Session->s_Nodes.back());
 
     // Standard scrubber from examples.
     BuildNode(&s_Session->s_Nodes.back());
 
+    JournalNodeCreated(s_Session->s_Nodes.back());
+
     // "return" value from example spawner
     return &s_Session->s_Nodes.back();
 }
@@ -45,19 +163,26 @@ plano::types::Node* RestoreRegistryNode(const std::string& NodeName, int id, con
     
     // Standard node spawner behavior, only we construct the objects
     // using the registry data.
-    // NodeRegistry is a map, so we need the value.
-    NodeDescription Desc = s_Session->NodeRegistry[NodeName];
+    const RegisteredType* Type = FindNodeType(NodeName);
+    assert(Type != nullptr); // The node type must be registered.
+    const NodeDescription& Desc = Type->Description;
 
     // Create node object and pass the type name and color.
     s_Session->s_Nodes.emplace_back(id, Desc.Type.c_str(),Desc.Color);
+    InvalidateIdIndex();
 
     // Handle creating the pins
     int pin_id_idx = 0;
-    for(PinDescription p : Desc.Inputs)
+    for(const PinDescription& p : Desc.Inputs)
         s_Session->s_Nodes.back().Inputs.emplace_back(pin_ids[pin_id_idx++], p.Label.c_str(), p.DataType);
-    for(PinDescription p : Desc.Outputs)
+    for(const PinDescription& p : Desc.Outputs)
         s_Session->s_Nodes.back().Outputs.emplace_back(pin_ids[pin_id_idx++], p.Label.c_str(), p.DataType);
 
+    // Until the save file's record is read, the node has its type's defaults.
+    s_Session->s_Nodes.back().PropertyDefaults = Type->Defaults;
+    ShareDefaultProperties(s_Session->s_Nodes.back());
+    StampNewNode(s_Session->s_Nodes.back());
+
     // Standard scrubber from examples.
     BuildNode(&s_Session->s_Nodes.back());
 
@@ -16,7 +16,9 @@
 #include <internal/internal.h>
 #include <plano_types.h>
 #include <plano_api.h>
-#include <internal/draw_utils.h> // GetIconColor is needed to color links at link load time
+#include <internal/serialization.h>
+#include <internal/journal.h>
+#include <internal/compression.h>
 
 
 #include <string>
@@ -51,6 +53,10 @@ types::ContextData* CreateContext(const types::ContextCallbacks& Config, const c
 
 void DestroyContext(ContextData* context)
 {
+    if (prop_blob_store::current() == &context->Blobs)
+        prop_blob_store::set_current(nullptr);
+    if (s_Session == context)
+        s_Session = nullptr;
     delete context;
     context = nullptr;
 }
@@ -58,6 +64,7 @@ void DestroyContext(ContextData* context)
 void SetContext(ContextData* context)
 {
     ax::NodeEditor::SetCurrentEditor(context->m_Editor);
+    prop_blob_store::set_current(&context->Blobs);
     s_Session = context;
 }
 
@@ -66,6 +73,20 @@ const types::ContextData* GetContext()
     return s_Session;
 }
 
+ScopedContext::ScopedContext(types::ContextData* context):
+    Previous(s_Session),
+    PreviousBlobs(prop_blob_store::current())
+{
+    prop_blob_store::set_current(context ? &context->Blobs : nullptr);
+    s_Session = context;
+}
+
+ScopedContext::~ScopedContext()
+{
+    prop_blob_store::set_current(PreviousBlobs);
+    s_Session = Previous;
+}
+
 bool IsProjectDirty()
 {
     if (s_Session == nullptr)
@@ -84,209 +105,584 @@ void ClearProjectDirtyFlag()
 }
 void RegisterNewNode(api::NodeDescription NewDescription) {
     assert(s_Session != nullptr); // You forgot to call CreateContext();
-    
-    assert(s_Session->NodeRegistry.count(NewDescription.Type) < 1); // you can't register 2 nodes with the same name.
-    s_Session->NodeRegistry[NewDescription.Type] = NewDescription;
-}
 
+    // A shared registry stays as it is: the context's own types go in a registry of their own, on top of it.
+    auto& registry = s_Session->Registry;
+    if (registry->Frozen) {
+        auto own = std::make_shared<NodeRegistry>();
+        own->Base = registry;
+        registry = own;
+    }
+    registry->Add(std::move(NewDescription));
+    StructureChanged(); // Existing nodes of the type may have an Evaluate callback now.
+}
 
-#include <sstream>
-void LoadNodesAndLinksFromBuffer(const size_t in_size, const char* buffer)
+std::shared_ptr<types::NodeRegistry> CreateNodeRegistry()
 {
-    // do nothing if there is no data
-    if(in_size < 1)
-        return;
-
+    return std::make_shared<NodeRegistry>();
+}
 
-    // Extremely bad deserialization system
-    // PHASE ONE - READ FILE TO MEMORY --------------------------------------------
-    std::string line; // tracks current line in file read loop
+void RegisterNewNode(types::NodeRegistry* registry, NodeDescription NewDescription)
+{
+    assert(registry != nullptr);
+    registry->Add(std::move(NewDescription));
+}
 
-    std::stringstream inf;
-    inf << std::string(buffer,in_size);
+void FreezeNodeRegistry(types::NodeRegistry* registry)
+{
+    assert(registry != nullptr);
+    registry->Frozen = true;
+}
 
-    int id = 0; // actual node id.  Note that the node id and s_Nodes[x] index are NOT THE SAME.
+void UseNodeRegistry(std::shared_ptr<types::NodeRegistry> registry)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext();
+    assert(registry && registry->Frozen); // Freeze it first: contexts may only share a registry nobody writes to.
+    s_Session->Registry = std::move(registry);
+    StructureChanged();
+}
 
-    std::string NodeName;  // Actually node type    
-    std::string Properties; // Whole, intact, Properties table after the loop.
-    int PropertiesCount; // Count of properties lines under a node section.
+size_t GetNodeTypeCount()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext();
+    return s_Session->Registry->Count();
+}
 
-    // First line is config json.
-    std::getline(inf, line);
-    assert(s_Session != nullptr); // you forgot to call CreateContext();
-    s_Session->s_BlueprintData = line;
+const prop_schema* GetPropertySchema(const std::string& NodeType)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext();
 
+    const RegisteredType* type = FindNodeType(NodeType);
+    return type ? type->Schema.get() : nullptr;
+}
 
-    // second overall line is node count.
-    std::getline(inf,line);
+template <typename T>
+size_t QueryPropertyColumn(const std::string& NodeType, const prop_field<T>& Field, PropertyColumn<T>& Column)
+{
+    const std::vector<size_t>& positions = NodesOfType(NodeType);
+    Column.Ids.clear();
+    Column.Values.clear();
+    Column.Ids.reserve(positions.size());
+    Column.Values.reserve(positions.size());
+
+    for (size_t position : positions) {
+        Node& node = s_Session->s_Nodes[position];
+        if (const T* value = PeekProperties(node).find(Field)) {
+            Column.Ids.push_back(node.ID);
+            Column.Values.push_back(*value);
+        }
+    }
+    return Column.Ids.size();
+}
 
-    int node_count = std::stol(line);
+// Writes one value, leaving the node alone (and sharing its defaults, if it does) when it already has it.
+template <typename T>
+static bool SetPropertyValue(Node& node, const prop_field<T>& Field, const T& Value)
+{
+    const T* current = PeekProperties(node).find(Field);
+    if (current && *current == Value)
+        return false;
+    GetProperties(node)[Field] = Value;
+    NodePropertiesChanged(node, &Field.key, 1);
+    return true;
+}
 
-    // Processes each node in turn.  Note there are loads
-    // of more getline statements inside this loop, so this outer loop ends up iterating on whole node boundaries.
-    //while(std::getline(inf,line))
-    for (int i = 0; i < node_count; i++)
-    {
-        std::stringstream PropBuffer; // Accumulator for properties lines in a loop.
-
-        // Shuttle data into ID, NodeName, and Properties variables.
-
-        // first line in the "node sub group" is ID
-        std::getline(inf,line);
-        id = std::stol(line);
-        LogRestoredId(id); // Let the system know this ID is in use, so it doesn't try to use it for new items.
-
-        // Next line is the node type.
-        std::getline(inf,line);        
-        NodeName = line;
-
-        // next line is the count of pins
-        std::getline(inf,line);
-        int pin_count = std::stol(line);
-
-        // Read in pin ids to a vector
-        std::vector<int> pin_ids;
-        if(pin_count > 0) {
-            for(int pin_idx = 0; pin_idx < pin_count; pin_idx++)
-            {
-                std::getline(inf,line);
-                int pin_id = std::stol(line);
-                LogRestoredId(pin_id); // Let the system know this ID is in use, so it doesn't try to use it for new items.
-                pin_ids.push_back(pin_id);
-            }
+template <typename T>
+size_t SetPropertyColumn(const std::string& NodeType, const prop_field<T>& Field, const PropertyColumn<T>& Column)
+{
+    assert(Column.Ids.size() == Column.Values.size());
+    const std::vector<size_t>& positions = NodesOfType(NodeType);
+    auto& nodes = s_Session->s_Nodes;
+
+    // A column from QueryPropertyColumn lists the nodes in type order, so the next node of the type is tried
+    // before the id lookup.
+    size_t changed = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < Column.Ids.size(); i++) {
+        while (next < positions.size() && nodes[positions[next]].ID != Column.Ids[i] && !PeekProperties(nodes[positions[next]]).find(Field))
+            next++; // Query left this one out.
+        Node* node;
+        if (next < positions.size() && nodes[positions[next]].ID == Column.Ids[i]) {
+            node = &nodes[positions[next++]];
+        } else {
+            node = FindNode(Column.Ids[i]);
+            if (!node || node->Name != NodeType)
+                continue;
         }
+        changed += SetPropertyValue(*node, Field, Column.Values[i]);
+    }
+    return changed;
+}
+
+template <typename T>
+size_t FillPropertyColumn(const std::string& NodeType, const prop_field<T>& Field, const T& Value)
+{
+    size_t changed = 0;
+    for (size_t position : NodesOfType(NodeType))
+        changed += SetPropertyValue(s_Session->s_Nodes[position], Field, Value);
+    return changed;
+}
 
-        // Next is the count of properties.
-        std::getline(inf,line);
-        PropertiesCount = std::stol(line);
+template size_t QueryPropertyColumn(const std::string&, const prop_field<int>&, PropertyColumn<int>&);
+template size_t QueryPropertyColumn(const std::string&, const prop_field<float>&, PropertyColumn<float>&);
+template size_t QueryPropertyColumn(const std::string&, const prop_field<bool>&, PropertyColumn<bool>&);
+template size_t QueryPropertyColumn(const std::string&, const prop_field<std::string>&, PropertyColumn<std::string>&);
+template size_t SetPropertyColumn(const std::string&, const prop_field<int>&, const PropertyColumn<int>&);
+template size_t SetPropertyColumn(const std::string&, const prop_field<float>&, const PropertyColumn<float>&);
+template size_t SetPropertyColumn(const std::string&, const prop_field<bool>&, const PropertyColumn<bool>&);
+template size_t SetPropertyColumn(const std::string&, const prop_field<std::string>&, const PropertyColumn<std::string>&);
+template size_t FillPropertyColumn(const std::string&, const prop_field<int>&, const int&);
+template size_t FillPropertyColumn(const std::string&, const prop_field<float>&, const float&);
+template size_t FillPropertyColumn(const std::string&, const prop_field<bool>&, const bool&);
+template size_t FillPropertyColumn(const std::string&, const prop_field<std::string>&, const std::string&);
+
+
+// Reads a whole project (snapshot and journal) into the current session.  Returns false at the first malformed line.
+static bool ReadProject(LineReader& in)
+{
+    // First line is config json.
+    if (!in.ReadLine(s_Session->s_BlueprintData))
+        return false;
 
-        // Iterate over propreties
-        for(int i = 0; i < PropertiesCount * 3; i++) {
-            std::getline(inf,line);
-            // note that we have to re-add the endline because getline consumes it.
-            PropBuffer << line <<std::endl;
-        }
-        // now we have all the propreties!
-        Properties = PropBuffer.str();
+    // Then, if the project has binary property records, the keys they refer to.  That replaces the dictionary, so
+    // nodes loaded lazily before, whose binary records index the old one, are parsed first.
+    for (Node& node : s_Session->s_Nodes)
+        if (!node.PropertiesLoaded && node.PropertySpanBinary && !node.PropertySpan.empty())
+            GetProperties(node);
+    if (!ReadKeyDictionary(in))
+        return false;
 
-        // PHASE TWO - INSTANTIATE NODES ------------------------------------------
-        // Use data in Nodename and Properties to instantiate nodes from the registry
-        // (new node definition system)
-        if (s_Session->NodeRegistry.count(NodeName) > 0)
-        {
-            Node* n = RestoreRegistryNode(NodeName,id,pin_ids);
-            // Handle property through deserialization
-            Prop_Deserialize(n->Properties, Properties);
+    // second overall line is node count.
+    long node_count;
+    if (!in.ReadInt(node_count) || node_count < 0)
+        return false;
 
-        } // Done with node instantiation.
-    } // Done with a node processing section.  Loop back if there's another node (more lines in getline)
+    // PHASE TWO - INSTANTIATE NODES ------------------------------------------
+    // Processes each node in turn.  Each record is read and instantiated from the registry
+    // (see ReadNodeRecord), so this outer loop ends up iterating on whole node boundaries.
+    for (long i = 0; i < node_count; i++)
+        if (!ReadNodeRecord(in))
+            return false;
 
     // Make pins and node reference reflective.
     BuildNodes();
 
     // lets read the link count now.
-    std::getline(inf,line);
-    int link_count = std::stol(line);
+    long link_count;
+    if (!in.ReadInt(link_count) || link_count < 0)
+        return false;
 
     // Iterate over N links
-    for (int i = 0; i < link_count; i++)
-    {
-        // first is our id
-        std::getline(inf,line);
-        int link_id = std::stol(line);
-        LogRestoredId(link_id); // Let the system know this ID is in use, so it doesn't try to use it for new items.
-
-        // next is start pin id
-        std::getline(inf,line);
-        int start_pin_id = std::stol(line);
-
-        // last is end pin id
-        std::getline(inf,line);
-        int end_pin_id = std::stol(line);
+    for (long i = 0; i < link_count; i++)
+        if (!ReadLinkRecord(in))
+            return false;
+
+    // PHASE THREE - REPLAY JOURNAL -------------------------------------------
+    // Anything after the snapshot are journal records appended by incremental saves.
+    ResetJournal();
+    const char* journal_begin = in.At;
+    if (!ReplayJournal(in))
+        return false;
+    s_Session->Journal.BytesSinceSnapshot = (size_t)(in.At - journal_begin);
+    return true;
+}
 
+bool LoadNodesAndLinksFromBuffer(const size_t in_size, const char* buffer)
+{
+    assert(s_Session != nullptr); // you forgot to call CreateContext();
 
-        // construct a link
-        plano::types::Link l = plano::types::Link(link_id,start_pin_id,end_pin_id);
-        l.Color = GetIconColor(FindPin(start_pin_id)->Type);
+    // do nothing if there is no data
+    if(in_size < 1)
+        return true;
 
-        // attach it to session
-        s_Session->s_Links.push_back(std::move(l));
+    // PHASE ONE - READ FILE TO MEMORY --------------------------------------------
+    // Compressed projects are inflated up front (chunks in parallel), so the parser below only ever sees text.
+    std::string inflated;
+    size_t size = in_size;
+    if (IsCompressedFrame(buffer, in_size)) {
+        if (!DecompressFrames(buffer, in_size, inflated))
+            return false; // corrupt file
+        buffer = inflated.data();
+        size = inflated.size();
     }
+
+    // A damaged file must not leave half a project behind, so keep what was there to put it back.
+    // (Loading into a fresh context, the usual case, makes this free.)
+    auto nodes = s_Session->s_Nodes;
+    auto links = s_Session->s_Links;
+    auto next_id = s_Session->s_NextId;
+    auto settings = s_Session->s_BlueprintData;
+    auto keys = s_Session->PropertyKeys;
+
+    LineReader in(buffer, size);
+    if (ReadProject(in))
+        return true;
+
+    s_Session->s_Nodes = std::move(nodes);
+    s_Session->s_Links = std::move(links);
+    s_Session->s_NextId = next_id;
+    s_Session->s_BlueprintData = std::move(settings);
+    s_Session->PropertyKeys = std::move(keys);
+    s_Session->Journal.Replaying = false;
+    ResetJournal();
+    InvalidateIdIndex();
+    BuildNodes();
+    return false;
 }
 
 #include <sstream>
 
+// Hands serialized text to the caller, compressed into a frame if the context asks for it.
+static char* CopyToSaveBuffer(const std::string& text, size_t* size)
+{
+    std::string frame;
+    const std::string& data = s_Session->CompressSaves ? (frame = CompressFrame(text.data(), text.size())) : text;
+
+    *size = data.size();
+    char* out_buf = new char[*size];
+    memcpy(out_buf, data.data(), *size);
+    return out_buf;
+}
+
 // Caller owns return value for purposes of memory freeing.  Use delete on the return when you're done. Thank you!
 char* SaveNodesAndLinksToBuffer(size_t* size)
 {
     assert(s_Session != nullptr); // You forgot to call CreateContext()
     // Extremely bad serilzation system
     // std::ofstream out("nodos_project.txt");
-    std::ostringstream out;
+    std::string out;
 
     // First line is the config data from the backend.  This data is automatically saved to s_Session.s_BlueprintData
     // using callbacks that were registered to the engine's config strucutre on engine initialization. 
-    out << s_Session->s_BlueprintData << std::endl;
+    WriteLine(out, s_Session->s_BlueprintData);
+
+    // Binary property records name their keys through the file's key dictionary, which has to come before the nodes,
+    // so the nodes are written first and the dictionary goes in front of them.  Lazily loaded nodes still hold
+    // records that index the dictionary they were loaded with; keep it (and extend it) while any remain.
+    auto& dict = s_Session->PropertyKeys;
+    bool keep_keys = std::any_of(s_Session->s_Nodes.begin(), s_Session->s_Nodes.end(), [](const Node& node) {
+        return !node.PropertiesLoaded && node.PropertySpanBinary;
+    });
+    if (!keep_keys)
+        dict.clear();
 
     // Second line is the write node count first
-    out << s_Session->s_Nodes.size() << std::endl;
+    std::string nodes;
+    WriteLine(nodes, s_Session->s_Nodes.size());
 
     // For every node in s_Nodes...
-    for (unsigned long long i = 0; i < s_Session->s_Nodes.size(); i++)
-    {
-        // First line is ID
-        out << s_Session->s_Nodes[i].ID.Get() << std::endl;
-
-        // Next line is node type
-        out << s_Session->s_Nodes[i].Name << std::endl;
-
-        // the "count of pins" is next
-        int output_pin_count = s_Session->s_Nodes[i].Outputs.size();
-        int input_pin_count = s_Session->s_Nodes[i].Inputs.size();
-        int pin_count = output_pin_count + input_pin_count;
-        out << pin_count << std::endl;
-
-        // dump the input pin ids
-        for (int input_idx = 0; input_idx < input_pin_count; input_idx++ )
-        {
-            out << s_Session->s_Nodes[i].Inputs[input_idx].ID.Get() << std::endl;
-        }
+    for (const auto& node : s_Session->s_Nodes)
+        WriteNodeRecord(nodes, node, s_Session->BinaryProperties);
 
-        // then dump out the output pin ids
-        for (int output_idx = 0; output_idx < output_pin_count; output_idx++ )
-        {
-            out << s_Session->s_Nodes[i].Outputs[output_idx].ID.Get() << std::endl;
-        }
+    WriteKeyDictionary(out);
+    out.append(nodes);
 
-        // The next line is a number describing the count of properties lines.
-        unsigned long count;
-        std::string props = Prop_Serialize(s_Session->s_Nodes[i].Properties, count);
+    // next write link count
+    WriteLine(out, s_Session->s_Links.size());
 
-        out << count << std::endl;
+    // For every link in s_Links...
+    for (const auto& link : s_Session->s_Links)
+        WriteLinkRecord(out, link);
 
-        // Then the next lines are the actual property lines.
-        out << props;
-    }
+    // A full snapshot makes every journal record so far redundant.
+    ResetJournal();
 
-    // next write link count
-    out << s_Session->s_Links.size() << std::endl;
+    return CopyToSaveBuffer(out, size);
+}
 
-    // For every link in s_Links...
-    for (unsigned long long i = 0; i < s_Session->s_Links.size(); i++)
+void EnableJournal(bool enable)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Journal.Enabled = enable;
+}
+
+void SetJournalCompactionThreshold(size_t bytes)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Journal.CompactionThreshold = bytes;
+}
+
+// Caller owns return value for purposes of memory freeing.  Use delete on the return when you're done.
+char* SaveJournalToBuffer(size_t* size, bool* is_snapshot)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+
+    // Once the journal outgrows its threshold, loading would spend more time replaying than parsing,
+    // so fold everything into a fresh snapshot instead.
+    if (s_Session->Journal.BytesSinceSnapshot >= s_Session->Journal.CompactionThreshold)
     {
-        // First line is ID
-        out << s_Session->s_Links[i].ID.Get() << std::endl;
+        *is_snapshot = true;
+        return SaveNodesAndLinksToBuffer(size);
+    }
+
+    *is_snapshot = false;
+    return CopyToSaveBuffer(DrainJournal(), size);
+}
+
+void SetSaveCompression(bool enable)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->CompressSaves = enable;
+}
+
+void SetBinaryProperties(bool enable)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->BinaryProperties = enable;
+}
+
+void SetLazyPropertyLoading(bool enable)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->LazyProperties = enable;
+}
+
+Properties* GetNodeProperties(ax::NodeEditor::NodeId id)
+{
+    auto node = FindNode(id);
+    if (!node)
+        return nullptr;
+    return &GetProperties(*node);
+}
+
+const std::vector<ax::NodeEditor::NodeId>& GetChangedNodes()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return s_Session->Tracking.ChangedNodes;
+}
 
-        // next is start pin id
-        out << s_Session->s_Links[i].StartPinID.Get() << std::endl;
-        // next is end pin id
-        out << s_Session->s_Links[i].EndPinID.Get() << std::endl;
+unsigned long long GetNodePropertyGeneration(ax::NodeEditor::NodeId id)
+{
+    auto node = FindNode(id);
+    return node ? node->PropertyGeneration : 0;
+}
+
+unsigned long long GetNodePropertyGeneration(ax::NodeEditor::NodeId id, const char* key)
+{
+    auto node = FindNode(id);
+    return node ? PropertyGeneration(*node, prop_intern(key)) : 0;
+}
+
+void MarkNodePropertiesChanged(ax::NodeEditor::NodeId id, const char* key)
+{
+    auto node = FindNode(id);
+    if (!node)
+        return;
+    if (key) {
+        prop_key handle = prop_intern(key);
+        NodePropertiesChanged(*node, &handle, 1);
+    } else {
+        NodePropertiesChanged(*node, nullptr, 0);
     }
+}
 
-    *size = out.str().size();
-    char* out_buf = new char[*size];
-    memcpy(out_buf,out.str().c_str(),*size);
-    return out_buf;
+bool Evaluate()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return EvaluateGraph();
+}
+
+const types::Value* GetPinValue(ax::NodeEditor::PinId id)
+{
+    return PinValue(id);
+}
+
+void SetPinValue(ax::NodeEditor::PinId id, const types::Value& value)
+{
+    SetInputValue(id, value);
+}
+
+void MarkNodeForEvaluation(ax::NodeEditor::NodeId id)
+{
+    MarkNodeDirty(id);
+}
+
+bool EvaluateSlice(double milliseconds)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return EvaluateGraphSlice(milliseconds / 1000.0);
+}
+
+size_t GetLastEvaluationCount()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return s_Session->Evaluation.LastRun;
+}
+
+void SetEvaluationThreads(unsigned count)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Evaluation.Threads = count == 0 ? 1 : count;
+}
+
+bool EvaluateAsync()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return StartAsyncEvaluation();
+}
+
+bool PollEvaluation()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return PublishAsyncEvaluation();
+}
+
+bool IsEvaluating()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return s_Session->Async.Current != nullptr;
+}
+
+void WaitForEvaluation()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    FinishAsyncEvaluation();
+}
+
+void CancelEvaluation()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    AbandonAsyncEvaluation();
+}
+
+void SetProfiling(bool enabled)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Profiler.Enabled = enabled;
+}
+
+bool GetNodeProfile(ax::NodeEditor::NodeId id, types::NodeProfile& profile)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    const types::NodeProfile* found = FindProfile(id.Get());
+    if (!found)
+        return false;
+    profile = *found;
+    return true;
+}
+
+void ResetProfiles()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Profiler.Nodes.clear();
+}
+
+void ShowProfileOverlay(bool show)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->m_ShowProfile = show;
+}
+
+void SetMemoCapacity(size_t bytes)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Evaluation.Memo.SetCapacity(bytes);
+}
+
+void ClearMemoCache()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Evaluation.Memo.Clear();
+}
+
+void GetMemoStats(size_t* hits, size_t* misses, size_t* evictions, size_t* entries, size_t* bytes)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    internal::MemoCache::Stats stats = s_Session->Evaluation.Memo.GetStats();
+    if (hits)
+        *hits = stats.Hits;
+    if (misses)
+        *misses = stats.Misses;
+    if (evictions)
+        *evictions = stats.Evictions;
+    if (entries)
+        *entries = stats.Entries;
+    if (bytes)
+        *bytes = stats.Bytes;
+}
+
+template <typename T> static PinType BatchPinType();
+template <> PinType BatchPinType<bool>()  { return PinType::Bool; }
+template <> PinType BatchPinType<int>()   { return PinType::Int; }
+template <> PinType BatchPinType<float>() { return PinType::Float; }
+
+template <typename T>
+bool SetPinBatch(ax::NodeEditor::PinId id, const T* values, size_t count)
+{
+    return SetBatchInput(id, BatchPinType<T>(), values, count);
+}
+
+void ClearPinBatches()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    s_Session->Batch.Inputs.clear();
+}
+
+bool EvaluateBatch(size_t count)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return EvaluateGraphBatch(count);
+}
+
+template <typename T>
+const T* GetPinBatch(ax::NodeEditor::PinId id)
+{
+    return static_cast<const T*>(BatchColumn(id, BatchPinType<T>()));
+}
+
+template bool SetPinBatch(ax::NodeEditor::PinId, const bool*, size_t);
+template bool SetPinBatch(ax::NodeEditor::PinId, const int*, size_t);
+template bool SetPinBatch(ax::NodeEditor::PinId, const float*, size_t);
+template const bool*  GetPinBatch<bool>(ax::NodeEditor::PinId);
+template const int*   GetPinBatch<int>(ax::NodeEditor::PinId);
+template const float* GetPinBatch<float>(ax::NodeEditor::PinId);
+
+bool FireFlow(ax::NodeEditor::NodeId id, int output)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return FireFlowOutput(id, output);
+}
+
+size_t FireFlowEvent(const std::string& NodeType)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    std::vector<size_t> positions = NodesOfType(NodeType);   // A copy: the pin lookups can rebuild the index it lives in.
+    for (size_t position : positions)
+        FireFlowOutput(s_Session->s_Nodes[position].ID, -1);
+    return positions.size();
+}
+
+size_t SignalFlow(const char* signal)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return SignalFlows(signal);
+}
+
+size_t TickFlow(double now)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return TickFlows(now);
+}
+
+size_t GetFlowCount()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    return s_Session->Flow.Records.size() - s_Session->Flow.Free.size();
+}
+
+void StopFlows()
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    internal::StopFlows();
+}
+
+void GetPropertyBlobUsage(size_t* count, size_t* bytes)
+{
+    assert(s_Session != nullptr); // You forgot to call CreateContext()
+    if (count)
+        *count = s_Session->Blobs.count();
+    if (bytes)
+        *bytes = s_Session->Blobs.bytes();
 }
 
 
@@ -0,0 +1,42 @@
+#include <internal/profiler.h>
+#include <internal/internal.h>
+
+using namespace plano::types;
+
+namespace plano {
+namespace internal {
+
+static size_t PayloadBytes(const Value& value)
+{
+    switch (value.Type) {
+        case PinType::Bool:   return sizeof(bool);
+        case PinType::Int:    return sizeof(int);
+        case PinType::Float:  return sizeof(float);
+        case PinType::String: return value.String.size();
+        case PinType::Object: return sizeof(void*);
+        default:              return 0;
+    }
+}
+
+void RecordProfile(uintptr_t node, double seconds, const Value* outputs, size_t count)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    NodeProfile& profile = s_Session->Profiler.Nodes[node];
+    profile.Last = seconds;
+    profile.Average = profile.Calls == 0 ? seconds : profile.Average + (seconds - profile.Average) * 0.1;
+    profile.Total += seconds;
+    profile.Calls++;
+    profile.Bytes = 0;
+    for (size_t o = 0; o < count; o++)
+        profile.Bytes += PayloadBytes(outputs[o]);
+}
+
+const NodeProfile* FindProfile(uintptr_t node)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto found = s_Session->Profiler.Nodes.find(node);
+    return found == s_Session->Profiler.Nodes.end() ? nullptr : &found->second;
+}
+
+} // inner namespace
+} // outer namespace
@@ -0,0 +1,118 @@
+#include <internal/property_blob.h>
+#include <internal/property_key.h>
+
+#include <cstring>
+#include <new>
+
+static thread_local prop_blob_store* s_CurrentStore = nullptr;   // Per thread, like the current context.
+
+static prop_blob_data* NewBlob(const void* data, size_t size, uint32_t hash, prop_blob_store* store)
+{
+    prop_blob_data* blob = (prop_blob_data*)::operator new(sizeof(prop_blob_data) + size);
+    new (&blob->refs) std::atomic<uint32_t>(1);
+    blob->hash = hash;
+    blob->size = size;
+    blob->store = store;
+    memcpy((void*)blob->bytes(), data, size);
+    return blob;
+}
+
+prop_blob prop_blob::from_bytes(const void* data, size_t size)
+{
+    if (size == 0)
+        return prop_blob();
+    if (prop_blob_store* store = prop_blob_store::current())
+        return store->intern(data, size);
+    return prop_blob(NewBlob(data, size, prop_hash((const char*)data, size), nullptr));
+}
+
+bool prop_blob::operator==(const prop_blob& other) const
+{
+    if (d == other.d)
+        return true;
+    if (size() != other.size())
+        return false;
+    // Blobs of one store are unique, but blobs of different stores (or none) can still hold the same bytes.
+    if (d && other.d && d->store && d->store == other.d->store)
+        return false;
+    return memcmp(data(), other.data(), size()) == 0;
+}
+
+void prop_blob::release(void)
+{
+    if (!d)
+        return;
+    if (d->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (d->store)
+            d->store->erase(d);
+        d->refs.~atomic();
+        ::operator delete(d);
+    }
+    d = nullptr;
+}
+
+prop_blob_store::~prop_blob_store()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& entry : blobs)
+        entry.second->store = nullptr;
+}
+
+prop_blob prop_blob_store::intern(const void* data, size_t size)
+{
+    uint32_t hash = prop_hash((const char*)data, size);
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto range = blobs.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        prop_blob_data* blob = it->second;
+        if (blob->size != size || memcmp(blob->bytes(), data, size) != 0)
+            continue;
+        // A blob whose count already reached zero is being freed; never bring it back.
+        uint32_t refs = blob->refs.load(std::memory_order_relaxed);
+        while (refs != 0 && !blob->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed))
+            ;
+        if (refs != 0)
+            return prop_blob(blob);
+    }
+
+    prop_blob_data* blob = NewBlob(data, size, hash, this);
+    blobs.emplace(hash, blob);
+    total += size;
+    return prop_blob(blob);
+}
+
+void prop_blob_store::erase(prop_blob_data* blob)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto range = blobs.equal_range(blob->hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == blob) {
+            blobs.erase(it);
+            total -= blob->size;
+            return;
+        }
+    }
+}
+
+size_t prop_blob_store::count(void) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return blobs.size();
+}
+
+size_t prop_blob_store::bytes(void) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return total;
+}
+
+prop_blob_store* prop_blob_store::current(void)
+{
+    return s_CurrentStore;
+}
+
+void prop_blob_store::set_current(prop_blob_store* store)
+{
+    s_CurrentStore = store;
+}
@@ -0,0 +1,202 @@
+#include <internal/property_codec.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+uint32_t prop_dictionary::add(const prop_key& key)
+{
+    auto found = index.find(key.id);
+    if (found != index.end())
+        return found->second;
+    uint32_t position = (uint32_t)keys.size();
+    keys.push_back(key);
+    index.emplace(key.id, position);
+    return position;
+}
+
+uint32_t prop_dictionary::add(const std::string& name)
+{
+    auto found = names.find(name);
+    if (found != names.end())
+        return found->second;
+    uint32_t position = add(prop_intern(name));
+    names.emplace(name, position);
+    return position;
+}
+
+static void PutVarint(std::string& out, uint32_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+static void PutU32(std::string& out, uint32_t value)
+{
+    char bytes[4] = { (char)value, (char)(value >> 8), (char)(value >> 16), (char)(value >> 24) };
+    out.append(bytes, 4);
+}
+
+void prop_begin_binary(std::string& out, uint32_t entries)
+{
+    PutVarint(out, entries);
+}
+
+// One entry, its key already resolved to a dictionary position.
+static void PutEntry(std::string& out, prop_type type, uint32_t position, const void* value)
+{
+    out.push_back((char)type);
+    PutVarint(out, position);
+
+    uint32_t bits;
+    switch (type) {
+        case prop_type::pint:
+        case prop_type::pfloat:
+            memcpy(&bits, value, 4);
+            PutU32(out, bits);
+            break;
+        case prop_type::pbool:
+            out.push_back(*(const bool*)value ? 1 : 0);
+            break;
+        case prop_type::pstring: {
+            const std::string& text = *(const std::string*)value;
+            PutVarint(out, (uint32_t)text.size());
+            out.append(text);
+            break;
+        }
+        case prop_type::pints:
+        case prop_type::pfloats:
+        case prop_type::pblob: {
+            const prop_blob& blob = *(const prop_blob*)value;
+            PutVarint(out, (uint32_t)blob.size());
+            out.append((const char*)blob.data(), blob.size());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void prop_put_binary(std::string& out, prop_dictionary& dict, prop_type type, const prop_key& key, const void* value)
+{
+    PutEntry(out, type, dict.add(key), value);
+}
+
+void prop_put_binary(std::string& out, prop_dictionary& dict, prop_type type, const std::string& name, const void* value)
+{
+    PutEntry(out, type, dict.add(name), value);
+}
+
+static bool GetVarint(const unsigned char*& at, const unsigned char* end, uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (at >= end)
+            return false;
+        unsigned char byte = *at++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool prop_binary_reader::begin(uint32_t& entries)
+{
+    // Every entry takes at least 3 bytes, which bounds what a damaged count can claim.
+    return GetVarint(at, end, entries) && entries <= (size_t)(end - at) / 3;
+}
+
+bool prop_binary_reader::next(prop_type& type, const prop_key*& key)
+{
+    if (at >= end || *at < (unsigned char)prop_type::pstring || *at > (unsigned char)prop_type::pblob)
+        return false;
+    type = (prop_type)*at++;
+
+    uint32_t position;
+    if (!GetVarint(at, end, position) || position >= dict.keys.size())
+        return false;
+    key = &dict.keys[position];
+    return true;
+}
+
+bool prop_binary_reader::get(int& value)
+{
+    if (end - at < 4)
+        return false;
+    uint32_t bits = (uint32_t)at[0] | ((uint32_t)at[1] << 8) | ((uint32_t)at[2] << 16) | ((uint32_t)at[3] << 24);
+    memcpy(&value, &bits, 4);
+    at += 4;
+    return true;
+}
+
+bool prop_binary_reader::get(float& value)
+{
+    int bits;
+    if (!get(bits))
+        return false;
+    memcpy(&value, &bits, 4);
+    return true;
+}
+
+bool prop_binary_reader::get(bool& value)
+{
+    if (at >= end)
+        return false;
+    value = *at++ != 0;
+    return true;
+}
+
+bool prop_binary_reader::get(const char*& value, size_t& length)
+{
+    uint32_t size;
+    if (!GetVarint(at, end, size) || size > (size_t)(end - at))
+        return false;
+    value = (const char*)at;
+    length = size;
+    at += size;
+    return true;
+}
+
+std::string prop_format_float(float value)
+{
+    // 9 significant digits always read back to the same float; try fewer first so common values stay short.
+    char text[32];
+    for (int digits = 6; digits <= 9; digits++) {
+        snprintf(text, sizeof(text), "%.*g", digits, value);
+        if (strtof(text, nullptr) == value)
+            break;
+    }
+    return text;
+}
+
+char prop_text_letter(prop_type type)
+{
+    switch (type) {
+        case prop_type::pstring: return 's';
+        case prop_type::pint:    return 'i';
+        case prop_type::pfloat:  return 'f';
+        case prop_type::pbool:   return 'b';
+        case prop_type::pints:   return 'I';
+        case prop_type::pfloats: return 'F';
+        case prop_type::pblob:   return 'x';
+        default:                 return '?';
+    }
+}
+
+prop_type prop_text_type(char letter)
+{
+    switch (letter) {
+        case 's': return prop_type::pstring;
+        case 'i': return prop_type::pint;
+        case 'f': return prop_type::pfloat;
+        case 'b': return prop_type::pbool;
+        case 'I': return prop_type::pints;
+        case 'F': return prop_type::pfloats;
+        case 'x': return prop_type::pblob;
+        default:  return prop_type::empty;
+    }
+}
@@ -0,0 +1,45 @@
+#include <internal/property_key.h>
+
+#include <mutex>
+#include <unordered_map>
+
+// Function local, so handles can be interned from static initializers in any translation unit.
+static std::mutex& InternLock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+static std::unordered_map<std::string, prop_key>& InternedKeys()
+{
+    static std::unordered_map<std::string, prop_key> keys;
+    return keys;
+}
+
+prop_key prop_intern(const std::string& key)
+{
+    std::lock_guard<std::mutex> guard(InternLock());
+    auto& keys = InternedKeys();
+
+    auto found = keys.find(key);
+    if (found != keys.end())
+        return found->second;
+
+    // unordered_map never moves its elements, so the stored name can be handed out.
+    auto inserted = keys.emplace(key, prop_key()).first;
+    prop_key& handle = inserted->second;
+    handle.id = (uint32_t)keys.size();
+    handle.hash = prop_hash(key.data(), key.size());
+    handle.name = &inserted->first;
+    return handle;
+}
+
+prop_key prop_intern(const char* key, size_t length)
+{
+    return prop_intern(std::string(key, length));
+}
+
+prop_key prop_intern(const char* key)
+{
+    return prop_intern(std::string(key));
+}
@@ -0,0 +1,27 @@
+#include <internal/property_schema.h>
+
+#include <cassert>
+
+void prop_schema::add(const prop_key& key, prop_type type, const void* value)
+{
+    assert(type >= prop_type::pstring && type <= prop_type::pbool); // arrays and blobs can't be schema fields.
+    prop_schema_field f;
+    f.key = key;
+    f.type = type;
+    f.offset = 0;
+
+    if (type == prop_type::pstring) {
+        strings.push_back(*(const std::string*)value);
+        fields.push_back(f);
+        return;
+    }
+
+    // Natural alignment inside the block: 4 bytes for int and float, 1 for bool.
+    size_t size = type == prop_type::pbool ? sizeof(bool) : 4;
+    size_t offset = (prototype.size() + size - 1) / size * size;
+    prototype.resize(offset + size, 0);
+    memcpy(prototype.data() + offset, value, size);
+
+    f.offset = (uint32_t)offset;
+    fields.push_back(f);
+}
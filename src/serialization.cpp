@@ -0,0 +1,382 @@
+#include <internal/serialization.h>
+#include <internal/internal.h>
+#include <internal/draw_utils.h> // GetIconColor is needed to color links at link load time
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace plano::types;
+
+namespace plano {
+namespace internal {
+
+bool LineReader::ReadLine(const char*& begin, size_t& length)
+{
+    if (AtEnd())
+        return false;
+
+    const char* eol = (const char*)memchr(At, '\n', Remaining());
+    begin = At;
+    if (eol) {
+        length = (size_t)(eol - At);
+        At = eol + 1;
+    } else {
+        length = Remaining();
+        At = End;
+    }
+    return true;
+}
+
+bool LineReader::ReadLine(std::string& line)
+{
+    const char* begin;
+    size_t length;
+    if (!ReadLine(begin, length))
+        return false;
+    line.assign(begin, length);
+    return true;
+}
+
+bool LineReader::ReadInt(long& value)
+{
+    const char* begin;
+    size_t length;
+    return ReadLine(begin, length) && ParseInt(begin, length, value);
+}
+
+bool LineReader::ReadBytes(size_t size, const char*& begin)
+{
+    if (size > Remaining())
+        return false;
+    begin = At;
+    At += size;
+    return true;
+}
+
+bool ParseInt(const char* begin, size_t length, long& value)
+{
+    if (length == 0 || length > 32)
+        return false;
+
+    // strtol wants a terminated string, and the buffer isn't one.
+    char digits[33];
+    memcpy(digits, begin, length);
+    digits[length] = '\0';
+
+    char* end;
+    errno = 0;
+    value = std::strtol(digits, &end, 10);
+    if (end == digits || errno == ERANGE)
+        return false;
+    for (; *end; end++)
+        if (*end != ' ' && *end != '\t' && *end != '\r')
+            return false;
+    return true;
+}
+
+// Ids have to fit an int, with room for LogRestoredId to hand out the next one.
+static bool ReadId(LineReader& in, long& id)
+{
+    return in.ReadInt(id) && id > 0 && id < INT_MAX;
+}
+
+void WriteLine(std::string& out, unsigned long long value)
+{
+    out.append(std::to_string(value));
+    out.push_back('\n');
+}
+
+void WriteLine(std::string& out, const std::string& value)
+{
+    out.append(value);
+    out.push_back('\n');
+}
+
+void WriteKeyDictionary(std::string& out)
+{
+    const auto& keys = s_Session->PropertyKeys.keys;
+    if (keys.empty())
+        return;
+    out.push_back('k');
+    WriteLine(out, keys.size());
+    for (const auto& key : keys)
+        WriteLine(out, *key.name);
+}
+
+bool ReadKeyDictionary(LineReader& in)
+{
+    auto& dict = s_Session->PropertyKeys;
+    dict.clear();
+
+    // The section is optional: put the line back unless it's the section header.
+    const char* rewind = in.At;
+    const char* line;
+    size_t length;
+    if (!in.ReadLine(line, length))
+        return false;
+    long count;
+    if (length == 0 || line[0] != 'k') {
+        in.At = rewind;
+        return true;
+    }
+    if (!ParseInt(line + 1, length - 1, count) || count < 0 || (unsigned long)count > in.Remaining())
+        return false;
+
+    std::string key;
+    for (long i = 0; i < count; i++) {
+        if (!in.ReadLine(key))
+            return false;
+        dict.add(prop_intern(key));
+    }
+    return true;
+}
+
+void WriteNodeRecord(std::string& out, const Node& node, bool binary)
+{
+    // First line is ID
+    WriteLine(out, node.ID.Get());
+
+    // Next line is node type
+    WriteLine(out, node.Name);
+
+    // the "count of pins" is next
+    WriteLine(out, node.Inputs.size() + node.Outputs.size());
+
+    // dump the input pin ids, then the output pin ids
+    for (const auto& input : node.Inputs)
+        WriteLine(out, input.ID.Get());
+    for (const auto& output : node.Outputs)
+        WriteLine(out, output.ID.Get());
+
+    WritePropertiesRecord(out, node, binary);
+}
+
+// "b<size>\n", the record, "\n".
+static void WriteBinaryHeader(std::string& out, size_t size)
+{
+    out.push_back('b');
+    WriteLine(out, size);
+}
+
+void WritePropertiesRecord(std::string& out, const Node& node, bool binary)
+{
+    // A node nobody touched since loading still has its original record.  A node that still shares its type's
+    // defaults is an empty delta.
+    if (!node.PropertiesLoaded)
+    {
+        if (node.PropertySpanDelta)
+            out.append("d\n");
+        if (node.PropertySpanBinary) {
+            WriteBinaryHeader(out, node.PropertySpan.size());
+            out.append(node.PropertySpan);
+            out.push_back('\n');
+        } else {
+            WriteLine(out, node.PropertySpanEntries);
+            out.append(node.PropertySpan);
+        }
+        return;
+    }
+
+    // Only what differs from the defaults is written, behind a "d" line.
+    const Properties* defaults = nullptr;
+    if (node.PropertyDefaults && Prop_Covers(node.Properties, *node.PropertyDefaults)) {
+        out.append("d\n");
+        defaults = node.PropertyDefaults.get();
+    }
+
+    if (binary)
+    {
+        // Encode in place, then slip the header (which needs the size) in front of it.
+        size_t start = out.size();
+        Prop_SerializeBinary(node.Properties, s_Session->PropertyKeys, out, defaults);
+        std::string header;
+        WriteBinaryHeader(header, out.size() - start);
+        out.insert(start, header);
+        out.push_back('\n');
+        return;
+    }
+
+    // The next line is a number describing the count of properties lines.
+    unsigned long count;
+    std::string props = Prop_Serialize(node.Properties, count, defaults);
+    WriteLine(out, count);
+
+    // Then the next lines are the actual property lines.
+    out.append(props);
+}
+
+// Hands a record that was read to the node: kept as is for lazy loading, shared defaults if it's an empty delta,
+// parsed otherwise.
+static bool StorePropertiesRecord(Node* node, const char* record, size_t size, unsigned long entries, bool binary, bool delta, bool empty)
+{
+    if (!node)
+        return true;
+
+    if (delta && empty && node->PropertyDefaults) {
+        ShareDefaultProperties(*node);
+        return true;
+    }
+
+    if (s_Session->LazyProperties) {
+        node->Properties = Properties();
+        node->PropertySpan.assign(record, size);
+        if (!binary && size > 0 && node->PropertySpan.back() != '\n')
+            node->PropertySpan.push_back('\n'); // The buffer ended without a newline.
+        node->PropertySpanEntries = entries;
+        node->PropertySpanBinary = binary;
+        node->PropertySpanDelta = delta && node->PropertyDefaults;
+        node->PropertiesLoaded = false;
+        return true;
+    }
+
+    node->PropertySpan.clear();
+    node->PropertySpanEntries = 0;
+    node->PropertySpanBinary = false;
+    node->PropertySpanDelta = false;
+    node->PropertiesLoaded = true;
+    return ParsePropertiesRecord(*node, record, size, binary, delta);
+}
+
+// The rest of a binary properties record, after its "b" header.
+static bool ReadBinaryPropertiesRecord(LineReader& in, const char* header, size_t header_length, Node* node, bool delta)
+{
+    long size;
+    const char* record;
+    const char* newline;
+    size_t newline_length;
+    if (!ParseInt(header + 1, header_length - 1, size) || size < 0 || !in.ReadBytes((size_t)size, record))
+        return false;
+    if (!in.ReadLine(newline, newline_length) || newline_length != 0)
+        return false;
+
+    bool empty = size == 1 && record[0] == 0; // an entry count of 0
+    return StorePropertiesRecord(node, record, (size_t)size, 0, true, delta, empty);
+}
+
+bool ReadPropertiesRecord(LineReader& in, Node* node)
+{
+    // First is the count of properties, or the header of a binary record, either of which may follow a "d" line.
+    const char* header;
+    size_t header_length;
+    long PropertiesCount;
+    if (!in.ReadLine(header, header_length))
+        return false;
+    bool delta = header_length == 1 && header[0] == 'd';
+    if (delta && !in.ReadLine(header, header_length))
+        return false;
+    if (header_length > 0 && header[0] == 'b')
+        return ReadBinaryPropertiesRecord(in, header, header_length, node, delta);
+    if (!ParseInt(header, header_length, PropertiesCount) || PropertiesCount < 0 || (unsigned long)PropertiesCount > in.Remaining())
+        return false;
+
+    // The properties lines are taken as one span straight out of the buffer.  Each property is a key, value and
+    // type line; arrays and blobs then carry their raw bytes, which may contain newlines, so they're skipped by size.
+    const char* span_begin = in.At;
+    for (long i = 0; i < PropertiesCount; i++) {
+        const char* line;
+        size_t length;
+        const char* value;
+        size_t value_length;
+        if (!in.ReadLine(line, length) || !in.ReadLine(value, value_length) || !in.ReadLine(line, length))
+            return false;
+        if (length > 0 && prop_is_raw(prop_text_type(line[0]))) {
+            long size;
+            const char* bytes;
+            if (!ParseInt(value, value_length, size) || size < 0 || !in.ReadBytes((size_t)size, bytes))
+                return false;
+            if (!in.ReadLine(line, length) || length != 0)
+                return false;
+        }
+    }
+    return StorePropertiesRecord(node, span_begin, (size_t)(in.At - span_begin), (unsigned long)PropertiesCount, false, delta, PropertiesCount == 0);
+}
+
+bool ReadNodeRecord(LineReader& in, Node** node)
+{
+    if (node)
+        *node = nullptr;
+
+    // first line in the "node sub group" is ID
+    long id;
+    if (!ReadId(in, id))
+        return false;
+    LogRestoredId(id); // Let the system know this ID is in use, so it doesn't try to use it for new items.
+
+    // Next line is the node type.
+    std::string NodeName;
+    if (!in.ReadLine(NodeName))
+        return false;
+    if (!NodeName.empty() && NodeName.back() == '\r')
+        NodeName.pop_back();
+
+    // next line is the count of pins
+    long pin_count;
+    if (!in.ReadInt(pin_count) || pin_count < 0)
+        return false;
+
+    // Read in pin ids to a vector
+    std::vector<int> pin_ids;
+    for (long pin_idx = 0; pin_idx < pin_count; pin_idx++)
+    {
+        long pin_id;
+        if (!ReadId(in, pin_id))
+            return false;
+        LogRestoredId(pin_id); // Let the system know this ID is in use, so it doesn't try to use it for new items.
+        pin_ids.push_back(pin_id);
+    }
+
+    // Use data in Nodename to instantiate nodes from the registry.  Unknown types, and types whose pins changed
+    // since the file was saved, still have to consume their properties record.
+    Node* n = nullptr;
+    const RegisteredType* type = FindNodeType(NodeName);
+    if (type && type->Description.Inputs.size() + type->Description.Outputs.size() == pin_ids.size())
+        n = RestoreRegistryNode(NodeName, id, pin_ids);
+
+    if (!ReadPropertiesRecord(in, n))
+        return false;
+
+    if (node)
+        *node = n;
+    return true;
+}
+
+void WriteLinkRecord(std::string& out, const Link& link)
+{
+    // First line is ID
+    WriteLine(out, link.ID.Get());
+    // next is start pin id
+    WriteLine(out, link.StartPinID.Get());
+    // next is end pin id
+    WriteLine(out, link.EndPinID.Get());
+}
+
+bool ReadLinkRecord(LineReader& in)
+{
+    // first is our id, next is start pin id, last is end pin id
+    long link_id, start_pin_id, end_pin_id;
+    if (!ReadId(in, link_id) || !ReadId(in, start_pin_id) || !ReadId(in, end_pin_id))
+        return false;
+    LogRestoredId(link_id); // Let the system know this ID is in use, so it doesn't try to use it for new items.
+
+    // A link whose pins didn't make it (eg. their node type isn't registered) can't be drawn.
+    auto start_pin = FindPin((int)start_pin_id);
+    auto end_pin = FindPin((int)end_pin_id);
+    if (!start_pin || !end_pin)
+        return true;
+
+    // construct a link
+    Link l = Link((int)link_id, start_pin->ID, end_pin->ID);
+    l.Color = GetIconColor(start_pin->Type);
+
+    // attach it to session
+    s_Session->s_Links.push_back(std::move(l));
+    StructureChanged();
+    return true;
+}
+
+} // inner namespace
+} // outer namespace
@@ -0,0 +1,125 @@
+#include <internal/tracking.h>
+#include <internal/internal.h>
+
+using namespace plano::types;
+
+namespace plano {
+namespace internal {
+
+void EndTrackingFrame()
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& tracking = s_Session->Tracking;
+
+    tracking.ChangedNodes.swap(tracking.Changing);
+    tracking.Changing.clear();
+    tracking.Epoch++;
+}
+
+Properties& BeginNodeProperties(Node& node)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& tracking = s_Session->Tracking;
+
+    tracking.Writes.reset();
+
+    // Shared stays equal to the defaults across nodes of a type, so drawing them copies nothing.
+    tracking.DrawingShared = SharesDefaultProperties(node);
+    if (tracking.DrawingShared) {
+        if (tracking.SharedSource != node.PropertyDefaults.get()) {
+            tracking.Shared = *node.PropertyDefaults;
+            tracking.SharedSource = node.PropertyDefaults.get();
+        }
+        Prop_Track(tracking.Shared, &tracking.Writes);
+        return tracking.Shared;
+    }
+
+    Properties& properties = GetProperties(node);
+    Prop_Track(properties, &tracking.Writes);
+    return properties;
+}
+
+void EndNodeProperties(Node& node, bool edited)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& tracking = s_Session->Tracking;
+
+    Properties& drawn = tracking.DrawingShared ? tracking.Shared : node.Properties;
+    Prop_Track(drawn, nullptr);
+
+    bool everything = tracking.Writes.everything;
+    tracking.Keys.clear();
+    if (!everything)
+        Prop_LoggedChanges(drawn, tracking.Writes, tracking.Keys);
+
+    if (tracking.DrawingShared) {
+        // A write the log missed would leave Shared off the defaults for every later node of the type.
+        if (!everything && tracking.Keys.empty() && edited)
+            Prop_Diff(*node.PropertyDefaults, tracking.Shared, tracking.Keys);
+        if (!everything && tracking.Keys.empty())
+            return;
+
+        // First write: the node takes the edited copy as its own table.
+        node.Properties = std::move(tracking.Shared);
+        node.PropertySpanDelta = false;
+        node.PropertiesLoaded = true;
+        tracking.SharedSource = nullptr;
+        NodePropertiesChanged(node, everything ? nullptr : tracking.Keys.data(), tracking.Keys.size());
+        return;
+    }
+
+    if (everything || (tracking.Keys.empty() && edited)) {
+        // Rewritten wholesale, or edited where the log couldn't see: the keys are unknown, but the change isn't lost.
+        NodePropertiesChanged(node, nullptr, 0);
+    } else if (!tracking.Keys.empty()) {
+        NodePropertiesChanged(node, tracking.Keys.data(), tracking.Keys.size());
+    }
+}
+
+void StampNewNode(Node& node)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    node.PropertyGeneration = node.PropertyGenerationFloor = ++s_Session->Tracking.Generation;
+    node.PropertyGenerations.clear();
+}
+
+void NodePropertiesChanged(Node& node, const prop_key* keys, size_t count)
+{
+    assert(s_Session != nullptr); // you didn't call CreateContext();
+    auto& tracking = s_Session->Tracking;
+
+    unsigned long long generation = ++tracking.Generation;
+    node.PropertyGeneration = generation;
+    if (!keys) {
+        node.PropertyGenerationFloor = generation;
+        node.PropertyGenerations.clear();
+    }
+    for (size_t k = 0; k < count; k++) {
+        auto& generations = node.PropertyGenerations;
+        auto found = generations.begin();
+        while (found != generations.end() && found->first.id != keys[k].id)
+            ++found;
+        if (found != generations.end())
+            found->second = generation;
+        else
+            generations.emplace_back(keys[k], generation);
+    }
+
+    if (node.ChangeEpoch != tracking.Epoch) {
+        node.ChangeEpoch = tracking.Epoch;
+        tracking.Changing.push_back(node.ID);
+    }
+    s_Session->IsProjectDirty = true;
+    JournalNodePropertiesChanged(node.ID);
+}
+
+unsigned long long PropertyGeneration(const Node& node, const prop_key& key)
+{
+    for (const auto& entry : node.PropertyGenerations)
+        if (entry.first.id == key.id)
+            return entry.second;
+    return node.PropertyGenerationFloor;
+}
+
+} // inner namespace
+} // outer namespace
@@ -0,0 +1,136 @@
+#include <internal/work_pool.h>
+
+namespace plano {
+namespace internal {
+
+WorkPool::WorkPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+    for (unsigned t = 0; t < threads; t++)
+        Queues.emplace_back(new Queue());
+    for (unsigned t = 1; t < threads; t++)
+        Workers.emplace_back(&WorkPool::WorkerLoop, this, t);
+}
+
+WorkPool::~WorkPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Quit = true;
+    }
+    Wake.notify_all();
+    for (auto& worker : Workers)
+        worker.join();
+}
+
+void WorkPool::Start(size_t total, WorkFunction work, void* user)
+{
+    Work = work;
+    User = user;
+    Pending.store(total, std::memory_order_release);
+}
+
+void WorkPool::Push(unsigned thread, uint32_t task, bool main_only)
+{
+    Queue& queue = main_only ? MainOnly : *Queues[thread];
+    {
+        std::lock_guard<std::mutex> guard(queue.Lock);
+        queue.Tasks.push_back(task);
+    }
+    (main_only ? MainQueued : Queued).fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders the push before a sleeper's check, so the wakeup can't be lost.
+    { std::lock_guard<std::mutex> guard(Lock); }
+    if (main_only)
+        Wake.notify_all();  // Only thread 0 may take it; notify_one could wake someone else.
+    else
+        Wake.notify_one();
+}
+
+bool WorkPool::Take(unsigned thread, uint32_t& task)
+{
+    if (thread == 0 && MainQueued.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> guard(MainOnly.Lock);
+        if (!MainOnly.Tasks.empty()) {
+            task = MainOnly.Tasks.back();
+            MainOnly.Tasks.pop_back();
+            MainQueued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    if (Queued.load(std::memory_order_acquire) == 0)
+        return false;
+
+    // Our own newest task first, then the others' oldest.
+    for (size_t i = 0; i < Queues.size(); i++) {
+        Queue& queue = *Queues[(thread + i) % Queues.size()];
+        std::lock_guard<std::mutex> guard(queue.Lock);
+        if (queue.Tasks.empty())
+            continue;
+        if (i == 0) {
+            task = queue.Tasks.back();
+            queue.Tasks.pop_back();
+        } else {
+            task = queue.Tasks.front();
+            queue.Tasks.pop_front();
+        }
+        Queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkPool::RunTask(unsigned thread, uint32_t task)
+{
+    Work(User, task, thread);
+    if (Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        { std::lock_guard<std::mutex> guard(Lock); }
+        Wake.notify_all();
+    }
+}
+
+void WorkPool::WorkerLoop(unsigned thread)
+{
+    for (;;) {
+        uint32_t task;
+        if (Take(thread, task)) {
+            RunTask(thread, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(Lock);
+        Wake.wait(guard, [this] { return Quit || Queued.load(std::memory_order_acquire) > 0; });
+        if (Quit)
+            return;
+        guard.unlock();
+
+        // Someone else may have taken it first; then it's back to sleep.
+        if (Take(thread, task))
+            RunTask(thread, task);
+    }
+}
+
+void WorkPool::Finish()
+{
+    for (;;) {
+        uint32_t task;
+        if (Take(0, task)) {
+            RunTask(0, task);
+            continue;
+        }
+        if (Pending.load(std::memory_order_acquire) == 0)
+            break;
+
+        std::unique_lock<std::mutex> guard(Lock);
+        Wake.wait(guard, [this] {
+            return Pending.load(std::memory_order_acquire) == 0 || Queued.load(std::memory_order_acquire) > 0
+                || MainQueued.load(std::memory_order_acquire) > 0;
+        });
+    }
+    Work = nullptr;
+    User = nullptr;
+}
+
+} // inner namespace
+} // outer namespace